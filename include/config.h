@@ -5,6 +5,7 @@
 #include <map>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <imgui.h>
 #include <inipp.h>
 
@@ -19,6 +20,8 @@ struct ConfigData {
     bool Viewports = false;
     bool Rounding = true;
     bool Shadow = true;
+    bool Waveform = false;  // audio waveform over the osc seekbar
+    bool Scenes = false;    // scene cut index, marked on the osc seekbar
     bool operator==(const Interface_&) const = default;
   } Interface;
   struct Mpv_ {
@@ -26,6 +29,7 @@ struct ConfigData {
     bool UseWid = false;
     bool WatchLater = false;
     int Volume = 100;
+    bool Loudness = false;  // play scanned files at a common loudness
     bool operator==(const Mpv_&) const = default;
   } Mpv;
   struct Window_ {
@@ -35,6 +39,11 @@ struct ConfigData {
     int W = 0, H = 0;
     bool operator==(const Window_&) const = default;
   } Window;
+  struct Control_ {
+    bool Enabled = false;
+    std::string Address;  // socket path or host:port, empty for the default socket
+    bool operator==(const Control_&) const = default;
+  } Control;
   struct Font_ {
     std::string Path;
     int Size = 13;
@@ -44,6 +53,8 @@ struct ConfigData {
   struct Debug_ {
     std::string LogLevel = "status";
     int LogLimit = 500;
+    bool LogFile = false;
+    int LogFileSize = 10;  // MB
     bool operator==(const Debug_&) const = default;
   } Debug;
   struct Recent_ {
@@ -51,6 +62,10 @@ struct ConfigData {
     bool SpaceToPlayLast = false;
     bool operator==(const Recent_&) const = default;
   } Recent;
+  struct Files_ {
+    std::vector<std::string> Roots;
+    bool operator==(const Files_&) const = default;
+  } Files;
   bool operator==(const ConfigData&) const = default;
 };
 
@@ -80,14 +95,19 @@ class Config {
 
   std::string dir() const { return configDir; }
   std::string ipcSocket();
+  std::string handoffSocket();
+  std::string controlAddress();
+  std::string controlToken();
   std::vector<RecentItem> &getRecentFiles();
   void addRecentFile(const std::string& path, const std::string& title);
   void clearRecentFiles();
 
-  const ImWchar* buildGlyphRanges();
+  const ImWchar* buildGlyphRanges(ImFontAtlas* fonts);
+  void addGlyphs(std::string_view text);  // queue glyphs missing from the font atlas
 
   ConfigData Data;
   bool FontReload = false;
+  std::vector<ImWchar> PendingGlyphs;  // seen in text, missing from the atlas
 
  private:
   inipp::Ini<char> ini;
@@ -95,5 +115,7 @@ class Config {
   std::string configDir;
 
   std::vector<RecentItem> recentFiles;
+  ImFontGlyphRangesBuilder loadedGlyphs;  // glyphs in the current atlas
+  ImFontGlyphRangesBuilder extraGlyphs;   // glyphs seen in rendered text
 };
 }  // namespace ImPlay
\ No newline at end of file
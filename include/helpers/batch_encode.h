@@ -0,0 +1,43 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace ImPlay {
+// Encodes every input to its own output with up to `jobs` mpv instances at a time.
+// The output pattern takes {name} (input file name without extension), {dir} (input
+// directory) and {index} (1-based position), e.g. "proxies/{name}.mp4". Progress goes
+// to stderr, run() returns the summary.
+class BatchEncoder {
+ public:
+  BatchEncoder(std::map<std::string, std::string> options, std::string pattern, int jobs = 0);
+
+  nlohmann::json run(const std::vector<std::string> &inputs);
+
+  static bool isPattern(const std::string &output) { return output.find('{') != std::string::npos; }
+
+ private:
+  struct Job {
+    std::string input, output, error;
+    enum { Queued, Running, Done, Failed } state = Queued;
+    double duration = 0, percent = 0, elapsed = 0;
+    std::chrono::steady_clock::time_point started;
+  };
+
+  void encode(Job &job);
+  void printProgress(double elapsed);
+
+  std::map<std::string, std::string> options;
+  std::string pattern;
+  int jobs;
+
+  std::mutex lock;  // guards the state and progress of jobs
+  std::vector<Job> queue;
+};
+}  // namespace ImPlay
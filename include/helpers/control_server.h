@@ -0,0 +1,70 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace ImPlay {
+// Remote control over a Unix socket (a path) or localhost TCP (host:port), one JSON
+// object per line:
+//   {"id": 1, "commands": [["set", "pause", "yes"], ["seek", "10"]]}  -> {"id": 1, "results": [...]}
+//   {"id": 2, "get": ["playlist", "position"]}                          -> {"id": 2, "data": {...}}
+//   {"id": 3, "subscribe": ["position"]}                                -> {"id": 3, "data": {...}}
+// Subscribers then get {"event": "update", "data": {...}} with the keys that changed,
+// coalesced to at most one message per PushIntervalMs. An empty key list means all keys.
+// The Unix socket is only accessible by the user. Any local user can reach the TCP port, so
+// its clients must first send {"token": "..."} with the token in the config dir; requests
+// before that get {"error": "unauthorized"}.
+class ControlServer {
+ public:
+  // runs a command on the server thread, returns mpv's error string
+  using CommandHandler = std::function<std::string(const std::vector<std::string> &args)>;
+
+  ControlServer(std::string address, std::string token, CommandHandler handler);
+  ~ControlServer();
+
+  ControlServer(const ControlServer &) = delete;
+  ControlServer &operator=(const ControlServer &) = delete;
+
+  bool start();
+  void publish(const std::string &key, nlohmann::json value);  // any thread
+
+ private:
+  struct Client {
+    intptr_t fd;
+    std::string in, out;
+    bool authorized = false;
+    bool subscribed = false;
+    std::vector<std::string> keys;
+    std::map<std::string, uint64_t> sent;  // key -> version last pushed
+  };
+
+  void serve();
+  void handle(Client &client, const std::string &line);
+  nlohmann::json snapshot(const std::vector<std::string> &keys, Client *client = nullptr);
+  void push(Client &client);
+
+  const int PushIntervalMs = 50;
+  const size_t MaxBuffer = 16 * 1024 * 1024;
+
+  std::string address;
+  std::string token;
+  CommandHandler handler;
+  intptr_t listenFd = -1;
+  bool unixSocket = false;
+  std::thread thread;
+  std::atomic<bool> quit = false;
+  std::vector<Client> clients;
+
+  std::mutex lock;
+  std::map<std::string, std::pair<nlohmann::json, uint64_t>> state;  // key -> value, version
+  uint64_t version = 0;
+};
+}  // namespace ImPlay
@@ -0,0 +1,49 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ImPlay {
+// Walks a set of directories once on a background thread and caches the files found, then
+// keeps the best fuzzy matches of them on another one. A new query only rescans the cache,
+// following the walk while it's still running. Nothing here waits for the walk, so a slow
+// root never blocks the caller.
+class FileSearch {
+ public:
+  struct Result {
+    std::string path;
+    std::string name;
+    int score;
+  };
+  using Filter = std::function<bool(const std::string &name)>;
+
+  FileSearch();
+  ~FileSearch();
+
+  // walks roots first if they differ from the cached ones, or the cache was refreshed
+  void start(std::vector<std::filesystem::path> roots, std::string query, Filter filter);
+  void cancel();
+  void refresh();  // walk again on the next start, unless the last walk is recent
+
+  // Copy the ranked results if they changed since the last call.
+  bool poll(std::vector<Result> &results);
+  bool running() const;
+
+  size_t Limit = 1000;
+
+ private:
+  struct State;
+
+  static void walk(std::shared_ptr<State> state, uint64_t gen, std::vector<std::filesystem::path> roots);
+  void match();
+
+  std::shared_ptr<State> state;  // shared with the walker, which is never joined
+  std::thread matcher;
+};
+}  // namespace ImPlay
@@ -0,0 +1,39 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <type_traits>
+#include <imgui.h>
+
+namespace ImPlay {
+// On-disk cache of a built ImFontAtlas: texture pixels, glyph tables and the atlas
+// fields the renderer reads. Everything that affects the build must be fed to add()
+// before load() or save(), the cache file is named after the resulting hash.
+class FontCache {
+ public:
+  explicit FontCache(const std::filesystem::path &dir) : dir(dir) {}
+
+  void add(const void *data, size_t size);
+  void add(const std::string &str) { add(str.data(), str.size() + 1); }
+  void add(const ImWchar *ranges);
+  void addFile(const std::string &path);  // size and modify time, not the content
+  template <typename T>
+  void add(const T &value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    add(&value, sizeof(T));
+  }
+
+  // on success the atlas is ready for texture upload, without running Build()
+  bool load(ImFontAtlas *atlas) const;
+  bool save(const ImFontAtlas *atlas) const;
+
+ private:
+  std::filesystem::path path() const;
+
+  std::filesystem::path dir;
+  uint64_t key = 14695981039346656037ull;
+};
+}  // namespace ImPlay
@@ -0,0 +1,32 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ImPlay::Fuzzy {
+// A case-folded copy of a string, plus a bitmap of the characters it contains.
+// Build it once per item, then match as many queries as needed against it.
+struct Key {
+  std::string str;
+  uint64_t mask = 0;
+
+  Key() = default;
+  explicit Key(std::string_view text);
+};
+
+// Fold ASCII letters to lower case (SIMD when available).
+std::string fold(std::string_view text);
+uint64_t charMask(std::string_view folded);
+
+// Score a folded pattern against a folded key, fzf-style: every pattern character must
+// appear in order; matches at word boundaries and consecutive runs score higher.
+// Space separated terms in the pattern must all match. Returns 0 if there is no match.
+int score(std::string_view pattern, std::string_view text);
+
+// Append the indices of all masks that contain every bit of `mask`.
+void prefilter(uint64_t mask, const uint64_t *masks, size_t count, std::vector<uint32_t> &out);
+}  // namespace ImPlay::Fuzzy
@@ -0,0 +1,51 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+#include <functional>
+#include <vector>
+#include <imgui.h>
+
+struct FT_LibraryRec_;
+struct FT_FaceRec_;
+
+namespace ImPlay {
+// Adds glyphs to the main font of a built atlas without rebuilding it. The atlas sets aside
+// empty cells for them when it's built; each new character is rasterized with FreeType the
+// way imgui_freetype does it, drawn into a free cell and uploaded alone to the font texture.
+class GlyphLoader {
+ public:
+  static constexpr int Cells = 256;
+  using Source = std::function<std::vector<unsigned char>()>;  // the full font file, read on first use
+
+  GlyphLoader() = default;
+  GlyphLoader(const GlyphLoader &) = delete;
+  GlyphLoader &operator=(const GlyphLoader &) = delete;
+  ~GlyphLoader();
+
+  // Call on a cleared atlas before adding fonts, so a cached copy has the cells at the same index.
+  static void reserve(ImFontAtlas *atlas, float size);
+  // Before the atlas is built with reserve(), or loaded from a cache of one that was.
+  void reset(ImFontAtlas *atlas, float size, Source source);
+
+  // Draw the characters the font lacks into the texture. False once out of cells, the atlas
+  // has to be rebuilt then; characters the font file lacks too are skipped.
+  bool add(const std::vector<ImWchar> &chars);
+
+ private:
+  static int cellSize(float size) { return (int)size + (int)size / 4; }  // room for glyphs past the line box
+  int reserved() const;
+  bool open();
+  void close();
+
+  ImFontAtlas *atlas = nullptr;
+  float size = 0;
+  int cell = 0, count = 0, used = 0;
+  Source source;
+  bool failed = false;
+
+  std::vector<unsigned char> data;  // the face reads from it
+  FT_LibraryRec_ *library = nullptr;
+  FT_FaceRec_ *face = nullptr;
+};
+}  // namespace ImPlay
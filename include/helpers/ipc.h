@@ -0,0 +1,45 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+#include <atomic>
+#include <functional>
+#include <optional>
+#include <string>
+#include <thread>
+
+namespace ImPlay {
+// Local socket (a named pipe on Windows) speaking newline delimited messages: every
+// request line gets one reply line from the handler. Clients are served one at a time
+// on the server thread, so requests should be short.
+class IpcServer {
+ public:
+  using Handler = std::function<std::string(const std::string &request)>;
+
+  IpcServer(std::string path, Handler handler);
+  ~IpcServer();
+
+  IpcServer(const IpcServer &) = delete;
+  IpcServer &operator=(const IpcServer &) = delete;
+
+  bool start();
+
+ private:
+  void serve();
+
+  std::string path;
+  Handler handler;
+  std::thread thread;
+  std::atomic<bool> quit = false;
+#ifdef _WIN32
+  void *pipe = nullptr;
+#else
+  int listenFd = -1;
+  int wakeFds[2] = {-1, -1};
+#endif
+};
+
+// Sends one request and waits up to timeoutMs for the reply. Returns nullopt if nothing
+// listens on path, an empty string if the server didn't reply in time.
+std::optional<std::string> ipcRequest(const std::string &path, const std::string &request, int timeoutMs);
+}  // namespace ImPlay
@@ -2,39 +2,47 @@
 // SPDX-License-Identifier: GPL-2.0-only
 
 #pragma once
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <map>
 #include <imgui.h>
+#include <fmt/format.h>
+#include "helpers/lang_pack.h"
 
 namespace ImPlay {
-struct LangFont {
-  std::string path;
-  int size = 0;
-  int glyph_range = 0;
-};
+constexpr uint64_t langId(std::string_view key) {
+  uint64_t hash = 14695981039346656037ull;
+  for (char c : key) {
+    hash ^= (unsigned char)c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
 
-struct LangData {
-  std::string code;
-  std::string title;
-  std::vector<LangFont> fonts;
-  std::map<std::string, std::string> entries;
-
-  std::string get(std::string& key);
-};
+// Translated text for the current language, or the key itself if there is none.
+// The returned view stays valid until the language changes.
+std::string_view translate(uint64_t id, std::string_view key);
 
+// A translation key, hashed at compile time for "..."_i18n literals. Lookups don't allocate,
+// the key must be NUL-terminated and outlive the LangStr.
 class LangStr {
  public:
-  explicit LangStr(std::string key);
+  constexpr explicit LangStr(std::string_view key) : m_key(key), m_id(langId(key)) {}
+
+  std::string_view str() const { return translate(m_id, m_key); }
+  const char* c_str() const { return str().data(); }
 
-  operator std::string() const;
-  operator std::string_view() const;
-  operator const char*() const;
+  operator std::string() const { return std::string(str()); }
+  operator std::string_view() const { return str(); }
+  operator const char*() const { return c_str(); }
 
  private:
-  std::string m_str;
+  std::string_view m_key;
+  uint64_t m_id;
 };
 
-inline std::string format_as(LangStr s) { return s; }
+inline std::string_view format_as(LangStr s) { return s.str(); }
 
 const ImWchar* getLangGlyphRanges();
 
@@ -42,10 +50,11 @@ std::map<std::string, LangData>& getLangs();
 std::string& getLangFallback();
 std::string& getLang();
 
-std::string i18n(std::string key);
+// A key known only at runtime may be missing from the pack, the text is copied as the key may not outlive it.
+inline std::string i18n(std::string_view key) { return std::string(translate(langId(key), key)); }
 template <typename... T>
-inline std::string i18n_a(std::string key, T... args) {
-  return fmt::vformat(i18n(key), fmt::make_format_args(args...));
+inline std::string i18n_a(std::string_view key, T... args) {
+  return fmt::vformat(translate(langId(key), key), fmt::make_format_args(args...));
 }
-inline LangStr operator""_i18n(const char* key, size_t) { return LangStr(key); }
+consteval LangStr operator""_i18n(const char* key, size_t len) { return LangStr(std::string_view(key, len)); }
 }  // namespace ImPlay
\ No newline at end of file
@@ -0,0 +1,35 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ImPlay {
+struct LangFont {
+  std::string path;
+  int size = 0;
+  int glyph_range = 0;
+};
+
+struct LangData {
+  std::string code;
+  std::string title;
+  bool fallback = false;
+  std::vector<LangFont> fonts;
+  std::map<std::string, std::string> entries;
+
+  std::string get(std::string& key);
+};
+
+// Binary language packs: the JSON language files converted at build time (and user
+// files on first use), so the language list can be read without parsing any JSON and
+// entries are only decoded for the languages in use.
+namespace LangPack {
+bool parseJson(std::string_view json, LangData& lang);
+std::string write(const LangData& lang);
+bool read(std::string_view data, LangData& lang, bool withEntries);
+}  // namespace LangPack
+}  // namespace ImPlay
@@ -0,0 +1,45 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ImPlay {
+// Appends lines to a file from a background thread. When the file grows past
+// maxSize it is renamed to <name>.1 (older ones shift up to <name>.<maxFiles>).
+class LogFile {
+ public:
+  LogFile(std::filesystem::path path, size_t maxSize, int maxFiles = 3);
+  ~LogFile();
+
+  // never blocks on disk; lines are dropped if the writer falls too far behind
+  void write(std::string line);
+  uint64_t dropped() const { return droppedLines; }
+
+ private:
+  void writeLoop();
+  void rotate();
+
+  const size_t MaxPending = 65536;
+
+  std::filesystem::path path;
+  size_t maxSize;
+  int maxFiles;
+  std::ofstream file;
+  size_t written = 0;
+
+  std::thread worker;
+  std::mutex lock;
+  std::condition_variable cond;
+  std::vector<std::string> pending;
+  std::atomic<uint64_t> droppedLines = 0;
+  bool quit = false;
+};
+}  // namespace ImPlay
@@ -0,0 +1,91 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "helpers/mapped_file.h"
+
+namespace ImPlay {
+// Line index and background search over a memory mapped mpv log file, which may
+// still be growing. Lines are expected in mpv's "[time][level][prefix] text" format.
+class LogIndex {
+ public:
+  struct Line {
+    std::string_view text;
+    std::string_view prefix;
+    int level;  // index into Levels, -1 if unknown
+  };
+
+  struct Query {
+    std::string pattern;
+    bool regex = false;
+    bool matchCase = false;
+    int maxLevel = -1;  // match lines up to this level, -1 for any
+    std::string prefix;
+
+    bool empty() const { return pattern.empty() && maxLevel < 0 && prefix.empty(); }
+  };
+
+  static constexpr const char *Levels[] = {"fatal", "error", "warn", "info", "status", "v", "debug", "trace"};
+  // longer lines are shown and searched up to this, std::regex recurses once per character
+  static constexpr size_t MaxLineLength = 4096;
+
+  LogIndex() = default;
+  ~LogIndex();
+
+  void open(const std::filesystem::path &path);
+  void close();
+  bool refresh();  // pick up new lines if the file grew, returns true if it did
+  bool isOpen() const { return file != nullptr; }
+  const std::filesystem::path &path() const { return m_path; }
+
+  size_t lineCount();
+  bool indexing() const { return m_indexing; }
+  Line line(size_t n);
+
+  // throws std::regex_error for an invalid pattern
+  void search(const Query &query);
+  bool searching() const { return m_searching; }
+  bool hasQuery() const { return !query.empty(); }
+  size_t matchCount();
+  size_t matchAt(size_t i);
+  bool isMatch(size_t line);
+  std::optional<size_t> nextMatch(size_t line, bool forward);
+  size_t matchIndex(size_t line);  // position of the first match >= line
+
+  static Line parse(std::string_view text);
+
+ private:
+  struct Matcher;
+
+  void startIndex(size_t from);
+  void startSearch(size_t from);
+  void stopIndex();
+  void stopSearch();
+  void indexLoop(uint64_t gen, std::shared_ptr<const MappedFile> mapped, size_t from);
+  void searchLoop(uint64_t gen, std::shared_ptr<const Matcher> matcher, size_t from);
+
+  std::filesystem::path m_path;
+  std::shared_ptr<const MappedFile> file;
+  Query query;
+  std::shared_ptr<const Matcher> matcher;
+
+  std::mutex lock;
+  std::vector<uint64_t> ends;      // end offset of each line, past its newline
+  std::vector<uint64_t> matches;   // matching line numbers, ascending
+  size_t searched = 0;             // lines searched so far
+
+  std::thread indexer, searcher;
+  std::atomic<uint64_t> indexGen = 0, searchGen = 0;
+  std::atomic<bool> m_indexing = false, m_searching = false;
+};
+}  // namespace ImPlay
@@ -0,0 +1,57 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ImPlay {
+// EBU R128 integrated loudness and sample peak of files, measured by lavfi's ebur128 in
+// headless mpv instances on a few low priority threads. Results are cached under dir, a small
+// file each, named after a hash of the path, size and modify time.
+class LoudnessScanner {
+ public:
+  static constexpr double Reference = -18;  // LUFS, as in ReplayGain 2.0
+
+  struct Result {
+    double integrated;  // LUFS
+    double peak;        // dBFS
+  };
+
+  explicit LoudnessScanner(const std::filesystem::path &dir, int workers = 0);
+  ~LoudnessScanner();
+
+  void request(const std::vector<std::string> &paths);  // most wanted first
+  std::optional<Result> lookup(const std::string &path);  // scanned files only, never waits
+
+  std::function<void(const std::string &path)> resultCb;  // path was measured, called on a worker thread
+
+ private:
+  void run();
+  std::filesystem::path cacheFile(uint64_t key) const;
+  bool measure(const std::string &path, uint64_t key, Result &result);
+  bool load(const std::filesystem::path &file, uint64_t key, Result &result) const;
+  void store(const std::filesystem::path &file, uint64_t key, const Result &result) const;
+
+  std::filesystem::path dir;
+  int workers;
+  std::vector<std::thread> threads;  // started on the first request
+  std::atomic<bool> quit = false;
+  std::mutex lock;
+  std::condition_variable cond;
+  std::deque<std::string> queue;
+  std::set<std::string> busy, failed;
+  std::map<std::string, Result> results;
+};
+}  // namespace ImPlay
@@ -0,0 +1,31 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+
+namespace ImPlay {
+// Read-only memory mapping of a whole file. Throws std::runtime_error if it can't be mapped.
+class MappedFile {
+ public:
+  explicit MappedFile(const std::filesystem::path &path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  const char *data() const { return m_data; }
+  size_t size() const { return m_size; }
+  std::string_view view() const { return {m_data, m_size}; }
+
+ private:
+  const char *m_data = nullptr;
+  size_t m_size = 0;
+#ifdef _WIN32
+  void *m_file = nullptr;
+  void *m_mapping = nullptr;
+#endif
+};
+}  // namespace ImPlay
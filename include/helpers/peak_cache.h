@@ -0,0 +1,53 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "helpers/mapped_file.h"
+
+namespace ImPlay {
+// Min/max peaks of a file's audio, downmixed to mono at SampleRate. The finest level has a
+// peak per BlockSize samples, each further level halves that. The first open decodes the
+// audio in the background with a headless mpv; the levels are cached under dir, named after
+// a hash of the path, size and modify time, and memory mapped on later opens. Closing only
+// cancels the decode, it winds down on its own.
+class PeakCache {
+ public:
+  static constexpr int SampleRate = 8000;
+  static constexpr int BlockSize = 64;
+
+  struct Peak {
+    int16_t min, max;
+  };
+
+  explicit PeakCache(const std::filesystem::path &dir) : dir(dir) {}
+  ~PeakCache();
+
+  void open(const std::string &path);
+  void close();
+
+  // one peak per column over [0, duration), from the coarsest level that still has a peak
+  // for every column; empty until ready
+  std::vector<Peak> columns(int count, double duration);
+
+ private:
+  void scan(std::string path, std::filesystem::path file, uint64_t key, std::shared_ptr<std::atomic<bool>> stop);
+  bool load(const std::filesystem::path &file, uint64_t key, const std::atomic<bool> *stop = nullptr);
+
+  std::filesystem::path dir;
+
+  std::mutex lock;  // guards the mapping and the scans
+  std::condition_variable idle;
+  std::shared_ptr<std::atomic<bool>> cancel;  // the latest scan's
+  int running = 0;
+  std::shared_ptr<const MappedFile> mapped;
+  std::vector<std::pair<const Peak *, size_t>> levels;  // finest first
+};
+}  // namespace ImPlay
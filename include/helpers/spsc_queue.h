@@ -0,0 +1,49 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace ImPlay {
+// Bounded lock-free queue for exactly one producer thread and one consumer thread.
+template <typename T>
+class SpscQueue {
+ public:
+  explicit SpscQueue(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+    slots.resize(size);
+    mask = size - 1;
+  }
+
+  // producer side, returns false if the queue is full
+  bool push(T &&value) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) > mask) return false;
+    slots[t & mask] = std::move(value);
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  // approximate when called while the other side is busy
+  size_t size() const { return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire); }
+  size_t capacity() const { return mask + 1; }
+
+  // consumer side, returns false if the queue is empty
+  bool pop(T &value) {
+    size_t h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire)) return false;
+    value = std::move(slots[h & mask]);
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  std::vector<T> slots;
+  size_t mask;
+  alignas(64) std::atomic<size_t> head = 0;
+  alignas(64) std::atomic<size_t> tail = 0;
+};
+}  // namespace ImPlay
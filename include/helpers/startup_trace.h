@@ -0,0 +1,28 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ImPlay {
+// Milliseconds from process start to each startup milestone, e.g. time to window
+// and time to the first video frame. Marks may come from any thread.
+class StartupTrace {
+ public:
+  static StartupTrace &get();
+
+  void mark(const char *name);  // only the first mark of a name is kept
+  std::vector<std::pair<std::string, double>> marks();
+
+ private:
+  StartupTrace() = default;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::mutex lock;
+  std::vector<std::pair<std::string, double>> items;
+};
+}  // namespace ImPlay
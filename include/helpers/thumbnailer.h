@@ -0,0 +1,127 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#ifdef IMGUI_IMPL_OPENGL_ES3
+#include <GLES3/gl3.h>
+#else
+#include <GL/gl.h>
+#endif
+#include <imgui.h>
+#include <mpv/client.h>
+#include <mpv/render.h>
+
+namespace ImPlay {
+// A headless mpv that decodes single keyframes at thumbnail size with the software
+// render API, no GL context needed. Not thread safe, each worker owns its own.
+class Thumbnailer {
+ public:
+  struct Frame {
+    int width = 0, height = 0;
+    std::vector<uint8_t> pixels;  // RGBA, rows tightly packed
+  };
+
+  Thumbnailer(int maxWidth, int maxHeight);
+  ~Thumbnailer();
+
+  bool load(const std::string &path);    // false if the file has no video
+  bool grab(double time, Frame &frame);  // the keyframe at or before time
+  double duration() const { return duration_; }
+
+ private:
+  bool waitEvent(mpv_event_id id, double timeout, bool endFails = true);
+  bool waitFrame(double timeout);
+
+  mpv_handle *ctx = nullptr;
+  mpv_render_context *render = nullptr;
+  int maxWidth, maxHeight;
+  double duration_ = 0;
+
+  std::mutex lock;
+  std::condition_variable cond;
+  bool updated = false;  // set by the render update callback
+};
+
+// Fixed size cells in one texture, filled from any thread and uploaded on the GL thread.
+// When all cells are taken, the least recently looked up one is reused, unless it's still in view:
+// a cell looked up in the current or the previous frame is never given away.
+class ThumbnailAtlas {
+ public:
+  static constexpr int CellWidth = 192, CellHeight = 108;
+
+  struct Cell {
+    ImVec2 size, uv0, uv1;
+  };
+
+  ThumbnailAtlas(int cols, int rows);
+
+  void newFrame();
+  bool put(const std::string &key, Thumbnailer::Frame frame);  // false if every cell is in view
+  bool contains(const std::string &key);
+  bool lookup(const std::string &key, Cell &cell);  // uploaded cells only
+  int available();                                  // cells that can take a new key
+  void clear();
+
+  // these need the GL context current
+  void upload();
+  void destroy();
+  ImTextureID texture() const { return reinterpret_cast<ImTextureID>(static_cast<intptr_t>(tex)); }
+
+ private:
+  struct Entry {
+    std::string key;
+    int width = 0, height = 0, pitch = 0;  // pitch is the frame width, in pixels
+    std::vector<uint8_t> pixels;           // waiting for upload
+    bool uploaded = false;
+    uint64_t frame = 0;  // last looked up or put
+  };
+
+  bool inView(const Entry &entry) const { return !entry.key.empty() && entry.frame + 1 >= frame; }
+
+  int cols, rows;
+  GLuint tex = 0;
+  std::mutex lock;
+  uint64_t frame = 1;
+  std::vector<Entry> entries;                       // one per cell
+  std::list<int> lru;                               // used cells, most recent first
+  std::unordered_map<std::string, std::list<int>::iterator> index;
+};
+
+// Decodes one thumbnail per file into an atlas, keyed by path, on a few workers that each
+// own a Thumbnailer. Every request() replaces the queue, so files that are no longer wanted
+// are dropped before they're decoded.
+class ThumbnailPool {
+ public:
+  ThumbnailPool(ThumbnailAtlas &atlas, int workers = 0);
+  ~ThumbnailPool();
+
+  void request(const std::vector<std::string> &paths);  // most wanted first, as many as the atlas has room for
+  bool failed(const std::string &path);
+  void clearFailed();
+
+  std::function<void()> updateCb;  // a thumbnail is ready
+
+ private:
+  void run();
+
+  ThumbnailAtlas &atlas;
+  int workers;
+  std::vector<std::thread> threads;  // started on the first request
+  std::mutex lock;
+  std::condition_variable cond;
+  bool quit = false;
+  std::deque<std::string> queue;
+  std::set<std::string> busy, failed_;
+};
+}  // namespace ImPlay
@@ -0,0 +1,67 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "helpers/mapped_file.h"
+
+namespace ImPlay {
+// Sorted timestamps of the playing file. The first open scans the file in the background at
+// low priority with a headless mpv, collecting the timestamp of each frame that comes out of
+// the lavfi filters; the result is cached under dir as a flat array of seconds, named after a
+// hash of the path, size and modify time, and memory mapped on later opens. Closing only
+// cancels the scan, it winds down on its own.
+class TimeIndex {
+ public:
+  using Options = std::vector<std::pair<const char *, const char *>>;
+
+  TimeIndex(const std::filesystem::path &dir, Options options, const char *filters)
+      : dir(dir), options(std::move(options)), filters(filters) {}
+  ~TimeIndex();
+
+  void open(const std::string &path);
+  void close();
+
+  bool ready();
+  double snap(double time);    // the nearest entry, or time itself until ready
+  double before(double time);  // the last entry at or before time, or time itself
+  double after(double time);   // the first entry after time, or -1
+  std::vector<double> all();
+
+ private:
+  void scan(std::string path, std::filesystem::path file, uint64_t key, std::shared_ptr<std::atomic<bool>> stop);
+  bool load(const std::filesystem::path &file, uint64_t key, const std::atomic<bool> *stop = nullptr);
+
+  std::filesystem::path dir;
+  Options options;
+  const char *filters;
+
+  std::mutex lock;  // guards the mapping and the scans
+  std::condition_variable idle;
+  std::shared_ptr<std::atomic<bool>> cancel;  // the latest scan's
+  int running = 0;
+  std::shared_ptr<const MappedFile> mapped;
+  const double *times = nullptr;
+  size_t count = 0;
+};
+
+// Keyframes, decoding nothing else.
+class KeyframeIndex : public TimeIndex {
+ public:
+  explicit KeyframeIndex(const std::filesystem::path &dir);
+};
+
+// Scene cuts, found by lavfi's scdet on a downscaled copy of the video.
+class SceneIndex : public TimeIndex {
+ public:
+  explicit SceneIndex(const std::filesystem::path &dir);
+};
+}  // namespace ImPlay
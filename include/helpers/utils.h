@@ -28,6 +28,16 @@ inline float scaled(float n) { return n * ImGui::GetFontSize(); }
 inline ImVec2 scaled(const ImVec2& vector) { return vector * ImGui::GetFontSize(); }
 
 bool fileExists(std::string path);
+uint64_t fileKey(const std::string& path);  // a hash of the path, size and modify time, for caches
+// keep the maxFiles most recently written files with extension ext in dir
+void prune(const std::filesystem::path& dir, const std::string& ext, size_t maxFiles);
+// A new file in dir named prefix-<random>ext that no other process opened, readable by the user
+// only, or empty on failure. Files with ext nothing wrote to for an hour, left by a crash, go first.
+std::filesystem::path createScratchFile(const std::filesystem::path& dir, const std::string& prefix,
+                                        const std::string& ext);
+// a value for a filter option in a lavfi graph, escaped for the graph parser and the option parser
+std::string escapeLavfi(const std::string& value);
+void lowerThreadPriority();                  // of the calling thread, for background scans
 
 int openUrl(std::string url);
 void revealInFolder(std::string path);
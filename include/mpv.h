@@ -2,12 +2,18 @@
 // SPDX-License-Identifier: GPL-2.0-only
 
 #pragma once
+#include <algorithm>
+#include <atomic>
 #include <string>
 #include <vector>
 #include <functional>
 #include <filesystem>
+#include <memory>
+#include <thread>
 #include <mpv/client.h>
 #include <mpv/render_gl.h>
+#include "helpers/log_file.h"
+#include "helpers/spsc_queue.h"
 
 namespace ImPlay {
 typedef void *(*GLAddrLoadFunc)(const char *name);
@@ -20,12 +26,15 @@ class Mpv {
   using LogHandler = std::function<void(const char *, const char *, const char *)>;
   using Callback = std::function<void(Mpv *)>;
 
-  void init(GLAddrLoadFunc load, int64_t wid = 0);
+  void init(int64_t wid = 0);             // safe to call off the main thread
+  void initRender(GLAddrLoadFunc load);  // needs the GL context current
   void render(int w, int h, int fbo = 0, bool flip = true);
   bool wantRender();
   void reportSwap();
   void waitEvent(double timeout = 0);
   void requestLog(const char *level, LogHandler handler);
+  void logToFile(const std::filesystem::path &path, size_t maxSize);  // call before init()
+  uint64_t droppedLogs() const { return logDropped + (logFile ? logFile->dropped() : 0); }
   int loadConfig(const char *path);
 
   bool playing() { return playlistPlayingPos != -1; }
@@ -38,6 +47,7 @@ class Mpv {
   inline int command(const char *args) { return mpv_command_string(mpv, args); }
   inline int command(const char *args[]) { return mpv_command_async(mpv, 0, args); }
   int commandv(const char *arg, ...);
+  int commandSync(const std::vector<std::string> &args);  // waits for the command to finish
 
   std::string property(const char *name) {
     char *data = mpv_get_property_string(mpv, name);
@@ -66,8 +76,10 @@ class Mpv {
   void observeEvent(mpv_event_id event, const EventHandler &handler) { events.emplace_back(event, handler); }
   template <typename T, mpv_format format>
   void observeProperty(const std::string &name, const std::function<void(T data)> &handler) {
+    bool observed = std::any_of(propertyEvents.begin(), propertyEvents.end(),
+                                [&](auto &e) { return std::get<0>(e) == name && std::get<1>(e) == format; });
     propertyEvents.emplace_back(name, format, [=](void *data) { handler(*(T *)data); });
-    mpv_observe_property(mpv, 0, name.c_str(), format);
+    if (!observed) mpv_observe_property(mpv, 0, name.c_str(), format);
   }
 
   struct TrackItem {
@@ -122,6 +134,8 @@ class Mpv {
 
  private:
   void eventLoop();
+  void startLog();
+  void logLoop();
 
   void observeProperties();
   void initPlaylist(mpv_node &node);
@@ -133,9 +147,29 @@ class Mpv {
 
   int64_t wid = 0;
   mpv_handle *main = nullptr;
+  std::thread eventThread;
+  std::atomic<bool> eventQuit = false;
   mpv_handle *mpv = nullptr;
   mpv_render_context *renderCtx = nullptr;
   LogHandler logHandler = nullptr;
+
+  // log messages are captured on their own client and thread, started by the first
+  // requestLog() or logToFile(), and handed to logHandler from waitEvent() at most
+  // LogBatch lines at a time. Past half full the log thread wakes the main loop,
+  // which may be blocked while the window is hidden
+  struct LogMessage {
+    std::string prefix;
+    std::string level;
+    std::string text;
+  };
+  const size_t LogBatch = 2000;
+  mpv_handle *log = nullptr;
+  std::thread logThread;
+  std::atomic<bool> logQuit = false;
+  std::atomic<uint64_t> logDropped = 0;
+  std::atomic<bool> logWoken = false;
+  std::unique_ptr<SpscQueue<LogMessage>> logQueue;
+  std::unique_ptr<LogFile> logFile;
   Callback wakeupCb_, updateCb_;
 
   std::vector<std::tuple<mpv_event_id, EventHandler>> events;
@@ -2,7 +2,10 @@
 // SPDX-License-Identifier: GPL-2.0-only
 
 #pragma once
+#include <atomic>
+#include <future>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 #include <mutex>
@@ -16,12 +19,22 @@
 #include "views/view.h"
 #include "views/about.h"
 #include "views/debug.h"
+#include "views/log_viewer.h"
 #include "views/quickview.h"
 #include "views/settings.h"
+#include "views/video_wall.h"
 #include "views/context_menu.h"
 #include "views/command_palette.h"
+#include "views/compare.h"
+#include "views/seek_preview.h"
+#include "views/waveform.h"
+#include "helpers/control_server.h"
+#include "helpers/glyph_loader.h"
 #include "helpers/imgui.h"
+#include "helpers/ipc.h"
+#include "helpers/loudness.h"
 #include "helpers/nfd.h"
+#include "helpers/time_index.h"
 #include "helpers/utils.h"
 
 #define PLAYER_NAME "ImPlay"
@@ -33,7 +46,8 @@ class Player {
   ~Player();
 
  protected:
-  bool init(std::map<std::string, std::string> &options);
+  void start(std::map<std::string, std::string> options);  // mpv setup on a worker thread
+  bool init();  // waits for start(), then sets up rendering
   void shutdown();
 
   void initGui();
@@ -41,9 +55,12 @@ class Player {
   void saveState();
   void restoreState();
 
-  void loadFonts();
+  void startFonts();  // builds the atlas on a worker, initGui() waits for it
+  void loadFonts(bool save = true);
   void render();
   void renderVideo();
+  bool renderCores();
+  void blitVideo(GLuint readFbo, int w, int h);
 
   void onCursorEvent(double x, double y);
   void onScrollEvent(double x, double y);
@@ -55,6 +72,8 @@ class Player {
   Config *config = nullptr;
   Mpv *mpv = nullptr;
   int width = 1280, height = 720;
+  std::atomic<bool> redrawVideo = false;  // render the current frame again, e.g. at a new size
+  std::mutex contextLock;
 
  private:
   void updateWindowState();
@@ -72,6 +91,10 @@ class Player {
   void openURL();
   void openDvd(std::filesystem::path path);
   void openBluray(std::filesystem::path path);
+  void openWall(std::vector<std::string> paths);
+  void closeWall();
+  void openCompare(std::string path);
+  void closeCompare();
 
   void playlistSort(bool reverse = false);
 
@@ -80,6 +103,16 @@ class Player {
   void messageBox(std::string title, std::string msg);
 
   void load(std::vector<std::filesystem::path> files, bool append = false, bool disk = false);
+  std::vector<std::string> expand(std::vector<std::filesystem::path> files, std::vector<std::function<void()>> &after,
+                                  bool append = false, bool disk = false);
+  std::pair<int64_t, int64_t> loadList(const std::vector<std::string> &items, const char *action);
+  std::string handleIpc(const std::string &request);
+  void initControl();
+  void requestLoudness();
+  void applyLoudness();
+  float fontScale();
+  void loadStyle(float scale);
+  void buildFonts(ImFontAtlas *atlas, float scale, bool save);
   bool isMediaFile(std::string file);
   bool isSubtitleFile(std::string file);
 
@@ -107,11 +140,27 @@ class Player {
   virtual void SetWindowFloating(bool f) = 0;
   virtual void SetWindowFullscreen(bool fs) = 0;
   virtual void SetWindowShouldClose(bool c) = 0;
-
-  bool idle = true;
+  virtual void SetMirror(bool on) {}
+  virtual bool GetMirror() { return false; }
+
+  std::atomic<bool> idle = true;  // read by the mirror thread too
+  std::unique_ptr<ImFontAtlas> fontAtlas = std::make_unique<ImFontAtlas>();  // outlives the ImGui context
+  std::future<float> fontsBuilt;                                              // the scale it was built at
+  GlyphLoader glyphs;
+  bool glyphsFull = false;  // the next atlas rebuild is for runtime glyphs
+  std::future<bool> started;
   GLuint fbo = 0, tex = 0;
+  int videoWidth = 0, videoHeight = 0;  // size of tex, guarded by contextLock
+  GLsync blitFence = nullptr;           // the last mirror blit reading tex, guarded by contextLock
+  std::atomic<double> videoAspect = 0;
   ImTextureID logoTexture = nullptr;
-  std::mutex contextLock;
+  std::mutex loadLock;
+  IpcServer *ipcServer = nullptr;
+  ControlServer *controlServer = nullptr;
+  KeyframeIndex *keyframes = nullptr;
+  SceneIndex *scenes = nullptr;
+  LoudnessScanner *loudness = nullptr;
+  double loudnessGain = 0;  // dB of the @loudness filter, 0 while it isn't in the chain
 
   bool m_openURL = false;
   bool m_dialog = false;
@@ -120,10 +169,15 @@ class Player {
 
   Views::About *about;
   Views::Debug *debug;
+  Views::LogViewer *logViewer;
   Views::Quickview *quickview;
   Views::Settings *settings;
   Views::ContextMenu *contextMenu;
   Views::CommandPalette *commandPalette;
+  Views::VideoWall *videoWall;
+  Views::Compare *compare;
+  Views::SeekPreview *seekPreview;
+  Views::Waveform *waveform;
 
   const std::vector<std::string> videoTypes = {
       "yuv", "y4m",   "m2ts", "m2t",   "mts",  "mtv",  "ts",   "tsv",    "tsa",  "tts",  "trp",  "mpeg", "mpg",
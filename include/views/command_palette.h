@@ -2,16 +2,26 @@
 // SPDX-License-Identifier: GPL-2.0-only
 
 #pragma once
+#include <atomic>
+#include <condition_variable>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <map>
+#include <thread>
 #include <vector>
+#include "helpers/file_search.h"
+#include "helpers/fuzzy.h"
+#include "helpers/time_index.h"
 #include "view.h"
 
 namespace ImPlay::Views {
 class CommandPalette : public View {
  public:
   CommandPalette(Config *config, Mpv *mpv);
+  ~CommandPalette() override;
 
   struct CommandItem {
     std::string title;
@@ -24,18 +34,74 @@ class CommandPalette : public View {
   void show(int n, const char **args);
   void draw() override;
 
+  // decides which files the `files` provider lists, called from the search thread
+  void setFileFilter(FileSearch::Filter filter) { fileFilter = filter; }
+
+  SceneIndex *scenes = nullptr;  // of the player's file, listed by the `scenes` provider
+
  private:
+  struct ItemKey {
+    Fuzzy::Key title;
+    Fuzzy::Key tooltip;
+  };
+
+  // folded keys of the current items, never modified once built
+  struct Index {
+    std::vector<ItemKey> keys;
+    std::vector<uint64_t> masks;
+  };
+
+  struct MatchJob {
+    uint64_t generation = 0;
+    std::string query;
+    std::shared_ptr<const Index> index;
+    std::optional<std::vector<uint32_t>> base;  // refine these instead of scanning all items
+  };
+
+  struct MatchResult {
+    uint64_t generation = 0;
+    std::string query;
+    std::shared_ptr<const Index> index;
+    std::vector<uint32_t> all;  // every match, in item order
+    std::vector<uint32_t> top;  // best MaxMatches, by score
+  };
+
   void drawInput();
-  void drawList(float width);
+  void drawList();
+  void buildIndex();
   void match(const std::string &input);
+  bool runMatch(const MatchJob &job, MatchResult &result);
+  void applyResult(MatchResult &result);
+  void matchLoop();
+  void searchFiles(const std::string &query);
+  void pollFiles();
+  std::vector<std::filesystem::path> fileRoots();
 
-  std::map<std::string, std::function<void(const char*)>> providers;
+  const size_t MaxMatches = 1000;
+  const size_t AsyncThreshold = 5000;
+
+  std::map<std::string, std::function<void(const char *)>> providers;
   std::vector<char> buffer = std::vector<char>(1024, 0x00);
   std::vector<CommandItem> items;
-  std::vector<CommandItem> matches;
+  std::shared_ptr<const Index> index;
+  std::vector<uint32_t> matches;
+  MatchResult lastResult;
+  float labelWidth = 0;
   int64_t pos = -1;
   bool filtered = false;
   bool focusInput = false;
   bool justOpened = false;
+
+  FileSearch fileSearch;
+  FileSearch::Filter fileFilter;
+  bool streaming = false;
+
+  std::thread worker;
+  std::mutex workerLock;
+  std::condition_variable workerCond;
+  std::atomic<uint64_t> generation = 0;
+  std::optional<MatchJob> pendingJob;
+  std::optional<MatchResult> finishedResult;
+  bool workerQuit = false;
 };
-}  // namespace ImPlay::Views
\ No newline at end of file
+}  // namespace ImPlay::Views
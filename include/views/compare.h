@@ -0,0 +1,63 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#ifdef IMGUI_IMPL_OPENGL_ES3
+#include <GLES3/gl3.h>
+#else
+#include <GL/gl.h>
+#endif
+#include <imgui.h>
+#include "view.h"
+
+namespace ImPlay::Views {
+// Plays a second file next to the player's, side by side or split by a draggable wipe.
+// The second core follows the player: pause and seeks are mirrored, frame steps and
+// drift are caught up from time-pos, by an exact seek when paused or far off, and by
+// nudging its speed while playing.
+class Compare : public View {
+ public:
+  Compare(Config *config, Mpv *mpv);
+
+  void open(const std::string &path);  // no GL needed
+  // these need the GL context current
+  void initRender(GLAddrLoadFunc load);
+  void close();
+  bool render();  // returns true if the second video got a new frame
+
+  void draw() override;
+  void drawVideo(ImTextureID main);  // draws both videos over the main viewport
+  void cycleLayout();
+
+  bool active() const { return active_; }
+  bool sideBySide() const { return active_ && !wipe; }  // the player renders at half width
+
+  std::function<void()> updateCb;  // the second video has a new frame
+  std::function<void()> redrawCb;  // the player needs to render again at its new size
+
+ private:
+  void observe();
+  void seek();
+  void sync();
+
+  std::unique_ptr<Mpv> other;
+  std::string path, title;
+  GLuint fbo = 0, tex = 0;
+  int texWidth = 0, texHeight = 0;         // render thread only
+  std::atomic<int> width = 0, height = 0;  // framebuffer size of the second video, set by drawVideo()
+  std::atomic<bool> pending = false;
+  std::atomic<bool> active_ = false;
+  std::atomic<bool> wipe = false;
+
+  float split = 0.5f;  // wipe position, fraction of the viewport width
+  bool observing = false;
+  const double SeekTimeout = 2;  // seconds to wait for the second core to restart before syncing again
+  bool seeking = false;
+  double target = -1, seekTime = 0;  // time-pos and start of the last seek
+  double speed = 1, otherSpeed = 1, lastSync = 0;
+};
+}  // namespace ImPlay::Views
@@ -2,9 +2,18 @@
 // SPDX-License-Identifier: GPL-2.0-only
 
 #pragma once
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <map>
 #include <string>
+#include <string_view>
+#include <unordered_set>
 #include <imgui.h>
 #include "view.h"
 
@@ -20,7 +29,7 @@ class Debug : public View {
 
  private:
   struct Console {
-    explicit Console(Mpv *mpv);
+    Console(Config *config, Mpv *mpv);
     ~Console();
 
     void init(const char *level, int limit);
@@ -28,24 +37,57 @@ class Debug : public View {
 
     void ClearLog();
     void AddLog(const char *level, const char *fmt, ...);
+    void AddLog(const char *level, const char *prefix, std::string_view text);
+    void SetLimit(int limit);
     void ExecCommand(const char *command_line);
     int TextEditCallback(ImGuiInputTextCallbackData *data);
     void initCommands(std::vector<std::pair<std::string, std::string>> &commands);
-    ImFont *GetFont(const char *str);
 
     ImVec4 LogColor(const char *level);
 
     const std::vector<std::string> builtinCommands = {"HELP", "CLEAR", "HISTORY"};
 
     struct LogItem {
-      char *Str;
-      const char *Lev;
-      int FontIdx;
+      const char *Str;     // owned by Arena
+      const char *Lev;     // interned
+      const char *Prefix;  // interned, may be empty
+      bool Mono;           // pure ASCII, use the mono font
     };
 
+    // Append-only storage for log lines. Lines are evicted in the order they were added,
+    // so a chunk is recycled as soon as its last line is gone.
+    struct LogArena {
+      struct Chunk {
+        std::unique_ptr<char[]> Data;
+        size_t Size = 0;
+        size_t Used = 0;
+        size_t Lines = 0;
+      };
+      static constexpr size_t ChunkSize = 64 * 1024;
+
+      const char *Push(std::string_view str);
+      void Pop();
+      void Clear();
+
+      std::deque<Chunk> Chunks;
+      std::vector<Chunk> Spare;
+    };
+
+    struct StrHash {
+      using is_transparent = void;
+      size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+    };
+
+    void DrawItem(const LogItem &item);
+    const char *Intern(std::string_view str);
+
+    Config *config;
     Mpv *mpv;
     char InputBuf[256];
-    ImVector<LogItem> Items;
+    std::vector<LogItem> Items;  // ring buffer of at most LogLimit lines, oldest at Head
+    size_t Head = 0;
+    LogArena Arena;
+    std::unordered_set<std::string, StrHash, std::equal_to<>> Interned;
     ImVector<char *> Commands;
     ImVector<char *> History;
     int HistoryPos = -1;  // -1: new line, 0..History.Size-1 browsing history.
@@ -55,9 +97,62 @@ class Debug : public View {
     bool CommandInited = false;
     std::string LogLevel = "status";
     int LogLimit = 500;
+    int LimitInput = 500;  // applied once the edit is done
+  };
+
+  // samples playback counters on a background thread while the debug window is open
+  struct Performance {
+    explicit Performance(Mpv *mpv);
+    ~Performance();
+
+    void draw();
+    void setActive(bool active);
+    void addFrameTime(float ms);
+
+    struct Series {
+      void push(float value);
+      float last() const;
+      void stats(float &min, float &avg, float &max) const;
+
+      static constexpr int Capacity = 300;
+      std::array<float, Capacity> values{};
+      int head = 0;
+      int count = 0;
+    };
+
+    enum Metric {
+      VfFps,
+      FrameDrops,
+      DecoderDrops,
+      VoDelayed,
+      AvSync,
+      CacheDuration,
+      CacheSpeed,
+      FrameTime,
+      MetricCount,
+    };
+
+    void sampleLoop();
+    void sample();
+    void drawSeries(Metric metric, const char *label, const char *unit);
+
+    const int SampleRate = 10;  // Hz
+
+    Mpv *mpv;
+    std::array<Series, MetricCount> series;
+    std::array<int64_t, MetricCount> counters{};
+    bool primed = false;
+    float frameTimeMax = 0;
+
+    std::thread worker;
+    std::mutex lock;
+    std::condition_variable cond;
+    bool active = false;
+    bool quit = false;
   };
 
   void drawHeader();
+  void drawPerformance();
   void drawConsole();
   void drawBindings();
   void drawCommands();
@@ -67,6 +162,7 @@ class Debug : public View {
   void initData();
 
   Console *console = nullptr;
+  Performance *performance = nullptr;
   std::string version;
   std::string m_node = "Console";
   bool m_demo = false, m_metrics = false;
@@ -0,0 +1,37 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+#include <string>
+#include "helpers/log_index.h"
+#include "view.h"
+
+namespace ImPlay::Views {
+class LogViewer : public View {
+ public:
+  LogViewer(Config *config, Mpv *mpv);
+
+  void show(int n, const char **args);
+  void draw() override;
+
+ private:
+  void open(const std::filesystem::path &path);
+  void drawToolbar();
+  void drawSearch();
+  void drawLines();
+  void search();
+  void jump(bool forward);
+
+  LogIndex index;
+  std::string error;
+  char pattern[256] = "";
+  char prefix[64] = "";
+  bool regex = false;
+  bool matchCase = false;
+  bool onlyMatches = false;
+  int level = -1;
+  int64_t cursor = -1;
+  bool scrollToCursor = false;
+  double lastRefresh = 0;
+};
+}  // namespace ImPlay::Views
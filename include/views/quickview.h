@@ -1,6 +1,7 @@
 #pragma once
 #include <functional>
 #include <vector>
+#include "helpers/thumbnailer.h"
 #include "view.h"
 
 namespace ImPlay::Views {
@@ -11,6 +12,12 @@ class Quickview : public View {
   void show(const char *tab = nullptr);
   void draw() override;
 
+  // these need the GL context current
+  void render();
+  void close();
+
+  std::function<void()> updateCb;  // a playlist thumbnail is ready
+
  private:
 #define FREQ_COUNT 10
   struct AudioEqItem {
@@ -31,6 +38,8 @@ class Quickview : public View {
   void drawTracks(const char *title, const char *type, const char *prop, std::string pos);
   void drawTracks(const char *type, const char *prop, std::string pos);
   void drawPlaylistTabContent();
+  void drawPlaylistGrid(std::vector<Mpv::PlayItem> &items, int &selected,
+                        const std::function<void(Mpv::PlayItem *)> &contextMenu);
   void drawChaptersTabContent();
   void drawVideoTabContent();
   void drawAudioTabContent();
@@ -54,6 +63,10 @@ class Quickview : public View {
   bool tabSwitched = false;
   std::string curTab = "Video";
   std::vector<Tab> tabs;
+  bool playlistGrid = false;
+  bool gridDrawn = false;  // the grid was drawn in the last frame
+  ThumbnailAtlas thumbnails{12, 12};
+  ThumbnailPool thumbnailer{thumbnails};
 
   const char *audioEqFreqs[FREQ_COUNT] = {"31.25", "62.5", "125", "250", "500", "1k", "2k", "4k", "8k", "16k"};
   std::vector<AudioEqItem> audioEqPresets = {
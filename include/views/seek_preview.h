@@ -0,0 +1,57 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include "helpers/time_index.h"
+#include "helpers/thumbnailer.h"
+#include "view.h"
+
+namespace ImPlay::Views {
+// Thumbnails over the osc seekbar. The file is split in buckets of a few seconds, a worker
+// decodes one keyframe per bucket, the hovered one first and then its neighbours outwards.
+// Until the hovered bucket is ready, the nearest decoded one is shown.
+class SeekPreview : public View {
+ public:
+  SeekPreview(Config *config, Mpv *mpv);
+  ~SeekPreview() override;
+
+  // x and the seekbar's top and bottom are in video framebuffer pixels
+  void show(double time, float x, float top, float bottom);
+  void hide();
+  void draw() override;
+
+  // these need the GL context current
+  void render();
+  void close();
+
+  std::function<void()> updateCb;      // a thumbnail is ready
+  KeyframeIndex *keyframes = nullptr;  // of the player's file, buckets seek to its keyframes
+
+ private:
+  static constexpr int Prefetch = 8;  // buckets decoded on each side of the hovered one
+  static constexpr int Nearest = 64;  // how far to look for a stand-in
+
+  void run();
+  int next();  // the bucket to decode, -1 if none; with lock held
+  int bucket(double time) const;
+
+  ThumbnailAtlas atlas{8, 8};
+  std::thread worker;
+  std::mutex lock;
+  std::condition_variable cond;
+  bool quit = false;
+  std::string path, loaded;  // the player's file, and the one the worker has open
+  double duration = 0, interval = 1;
+  double hovered = -1;  // seekbar time under the cursor
+  std::set<int> failed;
+
+  bool visible = false;
+  float x = 0, top = 0, bottom = 0;
+};
+}  // namespace ImPlay::Views
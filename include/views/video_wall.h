@@ -0,0 +1,56 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#ifdef IMGUI_IMPL_OPENGL_ES3
+#include <GLES3/gl3.h>
+#else
+#include <GL/gl.h>
+#endif
+#include "view.h"
+
+namespace ImPlay::Views {
+// A grid of independent mpv cores, each rendering into its own texture at the size of
+// its tile. Frames are rendered on the shared video render thread, and only for tiles
+// that have a new frame or were resized. Only the focused tile decodes audio.
+class VideoWall : public View {
+ public:
+  VideoWall(Config *config, Mpv *mpv);
+
+  // the cores are created and started in parallel, no GL needed
+  void open(const std::vector<std::string> &paths);
+  // these need the GL context current
+  void initRender(GLAddrLoadFunc load);
+  void close();
+  bool render();  // returns true if any tile got a new frame
+
+  void draw() override;
+  bool active() const { return active_; }
+
+  std::function<void()> updateCb;                // a tile has a new frame
+  std::function<void(std::string path)> exitCb;  // leave the wall, playing path if it's not empty
+
+  static constexpr size_t MaxTiles = 16;
+
+ private:
+  struct Tile {
+    std::unique_ptr<Mpv> mpv;
+    std::string path;
+    GLuint fbo = 0, tex = 0;
+    int texWidth = 0, texHeight = 0;         // render thread only
+    std::atomic<int> width = 0, height = 0;  // framebuffer size of the tile, set by draw()
+    std::atomic<bool> pending = false;
+  };
+
+  void focus(size_t index);
+
+  std::vector<std::unique_ptr<Tile>> tiles;
+  std::atomic<bool> active_ = false;
+  size_t focused = 0;
+};
+}  // namespace ImPlay::Views
@@ -0,0 +1,31 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+#include <string>
+#include "helpers/peak_cache.h"
+#include "helpers/time_index.h"
+#include "view.h"
+
+namespace ImPlay::Views {
+// The playing file's audio waveform and scene cuts, drawn over the osc seekbar while the osc shows it.
+class Waveform : public View {
+ public:
+  Waveform(Config *config, Mpv *mpv);
+
+  void open(const std::string &path) { peaks.open(path); }
+  void close() { peaks.close(); }
+
+  // the seekbar, in video framebuffer pixels
+  void show(float x1, float y1, float x2, float y2);
+  void hide() { visible = false; }
+  void draw() override;
+
+  SceneIndex *scenes = nullptr;  // of the player's file, marked on the seekbar
+
+ private:
+  PeakCache peaks;
+  bool visible = false;
+  ImVec2 min, max;
+};
+}  // namespace ImPlay::Views
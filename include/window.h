@@ -27,6 +27,7 @@ class Window : Player {
 
  private:
   void initGLFW();
+  void createWindow();
   void wakeup();
   void updateCursor();
 
@@ -65,6 +66,10 @@ class Window : Player {
   void SetWindowFloating(bool f) override;
   void SetWindowFullscreen(bool fs) override;
   void SetWindowShouldClose(bool c) override;
+  void SetMirror(bool on) override;
+  bool GetMirror() override { return mirror != nullptr; }
+
+  void mirrorLoop();
 
   GLFWwindow *window = nullptr;
   bool ownCursor = true;
@@ -94,6 +99,13 @@ class Window : Player {
 
   struct Waiter videoWaiter;
 
+  // presenter mirror, a second window on a shared context showing the player's video texture
+  GLFWwindow *mirror = nullptr;
+  std::thread mirrorThread;
+  std::atomic<bool> mirrorQuit = false;
+  std::atomic<int> mirrorWidth = 0, mirrorHeight = 0;
+  struct Waiter mirrorWaiter;
+
   // clang-format off
   const std::map<int, std::string> keyMappings = {
       {GLFW_KEY_SPACE, "SPACE"}, {GLFW_KEY_APOSTROPHE, "'"},
@@ -131,6 +131,7 @@ local state = {
     maximized = false,
     osd = mp.create_osd_overlay("ass-events"),
     chapter_list = {},                      -- sorted by time
+    implay = {},                            -- last seekbar state sent to ImPlay, per message
 }
 
 local window_control_box_width = 80
@@ -620,6 +621,26 @@ function get_chapter(possec)
     end
 end
 
+-- sends seekbar state that ImPlay draws over the video, in OSD pixels, and only
+-- when it changed; nil args sends <name>-clear
+function notify_implay(name, args)
+    local key = args and table.concat(args, " ")
+    if key == state.implay[name] then
+        return
+    end
+    state.implay[name] = key
+    if key then
+        mp.commandv("script-message-to", "implay", name, (table.unpack or unpack)(args))
+    else
+        mp.commandv("script-message-to", "implay", name .. "-clear")
+    end
+end
+
+function clear_implay()
+    notify_implay("thumb", nil)
+    notify_implay("seekbar", nil)
+end
+
 function render_elements(master_ass)
 
     -- when the slider is dragged or hovered and we have a target chapter name
@@ -638,6 +659,7 @@ function render_elements(master_ass)
         end
     end
 
+    local thumb, bar = nil, nil
     for n=1, #elements do
         local element = elements[n]
 
@@ -680,6 +702,13 @@ function render_elements(master_ass)
 
             local slider_lo = element.layout.slider
             local elem_geo = element.layout.geometry
+
+            if element == state.slider_element then
+                local sx, sy = get_virt_scale_factor()
+                local hb = element.hitbox
+                bar = {tostring(math.floor(hb.x1 / sx)), tostring(math.floor(hb.y1 / sy)),
+                    tostring(math.floor(hb.x2 / sx)), tostring(math.floor(hb.y2 / sy))}
+            end
             local s_min = element.slider.min.value
             local s_max = element.slider.max.value
 
@@ -810,6 +839,13 @@ function render_elements(master_ass)
                     end
 
                     local tx = get_virt_mouse_pos()
+                    local dur = mp.get_property_number("duration", 0)
+                    if element == state.slider_element and dur > 0 then
+                        -- OSD pixels are the video framebuffer's
+                        local sx, sy = get_virt_scale_factor()
+                        thumb = {string.format("%.2f", sliderpos * dur / 100), tostring(math.floor(tx / sx)),
+                            tostring(math.floor(element.hitbox.y1 / sy)), tostring(math.floor(element.hitbox.y2 / sy))}
+                    end
                     if slider_lo.adjust_tooltip then
                         if an == 2 then
                             if sliderpos < (s_min + 3) then
@@ -867,6 +903,8 @@ function render_elements(master_ass)
 
         master_ass:merge(elem_ass)
     end
+    notify_implay("thumb", thumb)
+    notify_implay("seekbar", bar)
 end
 
 --
@@ -2041,11 +2079,9 @@ function osc_init()
             local seekto = get_slider_value(element)
             if element.state.lastseek == nil or
                 element.state.lastseek ~= seekto then
-                    local flags = "absolute-percent"
-                    if not user_opts.seekbarkeyframes then
-                        flags = flags .. "+exact"
-                    end
-                    mp.commandv("seek", seekto, flags)
+                    -- ImPlay snaps it to its keyframe index, if the file has one
+                    mp.commandv("script-message-to", "implay", "seekbar-drag", seekto,
+                        user_opts.seekbarkeyframes and "keyframes" or "exact")
                     element.state.lastseek = seekto
             end
 
@@ -2253,6 +2289,9 @@ function hide_osc()
 end
 
 function osc_visible(visible)
+    if not visible then
+        clear_implay()
+    end
     if state.osc_visible ~= visible then
         state.osc_visible = visible
         update_margins()
@@ -2314,6 +2353,7 @@ end
 
 function render_wipe()
     msg.trace("render_wipe()")
+    clear_implay()
     state.osd.data = "" -- allows set_osd to immediately update on enable
     state.osd:remove()
 end
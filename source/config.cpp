@@ -3,6 +3,8 @@
 
 #include <filesystem>
 #include <fstream>
+#include <random>
+#include <imgui_internal.h>
 #include "config.h"
 #include "helpers/utils.h"
 
@@ -29,6 +31,8 @@ void Config::load() {
   inipp::get_value(ini.sections["interface"], "viewports", Data.Interface.Viewports);
   inipp::get_value(ini.sections["interface"], "rounding", Data.Interface.Rounding);
   inipp::get_value(ini.sections["interface"], "shadow", Data.Interface.Shadow);
+  inipp::get_value(ini.sections["interface"], "waveform", Data.Interface.Waveform);
+  inipp::get_value(ini.sections["interface"], "scenes", Data.Interface.Scenes);
   inipp::get_value(ini.sections["font"], "path", Data.Font.Path);
   inipp::get_value(ini.sections["font"], "size", Data.Font.Size);
   inipp::get_value(ini.sections["font"], "glyph-range", Data.Font.GlyphRange);
@@ -36,14 +40,19 @@ void Config::load() {
   inipp::get_value(ini.sections["mpv"], "wid", Data.Mpv.UseWid);
   inipp::get_value(ini.sections["mpv"], "watch-later", Data.Mpv.WatchLater);
   inipp::get_value(ini.sections["mpv"], "volume", Data.Mpv.Volume);
+  inipp::get_value(ini.sections["mpv"], "loudness", Data.Mpv.Loudness);
   inipp::get_value(ini.sections["window"], "save", Data.Window.Save);
   inipp::get_value(ini.sections["window"], "single", Data.Window.Single);
+  inipp::get_value(ini.sections["control"], "enabled", Data.Control.Enabled);
+  inipp::get_value(ini.sections["control"], "address", Data.Control.Address);
   inipp::get_value(ini.sections["window"], "x", Data.Window.X);
   inipp::get_value(ini.sections["window"], "y", Data.Window.Y);
   inipp::get_value(ini.sections["window"], "w", Data.Window.W);
   inipp::get_value(ini.sections["window"], "h", Data.Window.H);
   inipp::get_value(ini.sections["debug"], "log-level", Data.Debug.LogLevel);
   inipp::get_value(ini.sections["debug"], "log-limit", Data.Debug.LogLimit);
+  inipp::get_value(ini.sections["debug"], "log-file", Data.Debug.LogFile);
+  inipp::get_value(ini.sections["debug"], "log-file-size", Data.Debug.LogFileSize);
   inipp::get_value(ini.sections["recent"], "limit", Data.Recent.Limit);
   inipp::get_value(ini.sections["recent"], "space-to-play-last", Data.Recent.SpaceToPlayLast);
 
@@ -51,6 +60,12 @@ void Config::load() {
     if (key.find("file-") != 0 || value == "") continue;
     auto parts = split(value, "|");
     recentFiles.push_back({parts.front(), parts.back()});
+    addGlyphs(parts.back());
+  }
+
+  for (auto& [key, value] : ini.sections["files"]) {
+    if (key.find("root-") != 0 || value == "") continue;
+    Data.Files.Roots.push_back(value);
   }
 
   getLang() = Data.Interface.Lang;
@@ -69,6 +84,8 @@ void Config::save() {
   ini.sections["interface"]["viewports"] = fmt::format("{}", Data.Interface.Viewports);
   ini.sections["interface"]["rounding"] = fmt::format("{}", Data.Interface.Rounding);
   ini.sections["interface"]["shadow"] = fmt::format("{}", Data.Interface.Shadow);
+  ini.sections["interface"]["waveform"] = fmt::format("{}", Data.Interface.Waveform);
+  ini.sections["interface"]["scenes"] = fmt::format("{}", Data.Interface.Scenes);
   ini.sections["font"]["path"] = Data.Font.Path;
   ini.sections["font"]["size"] = std::to_string(Data.Font.Size);
   ini.sections["font"]["glyph-range"] = std::to_string(Data.Font.GlyphRange);
@@ -76,14 +93,19 @@ void Config::save() {
   ini.sections["mpv"]["wid"] = fmt::format("{}", Data.Mpv.UseWid);
   ini.sections["mpv"]["watch-later"] = fmt::format("{}", Data.Mpv.WatchLater);
   ini.sections["mpv"]["volume"] = std::to_string(Data.Mpv.Volume);
+  ini.sections["mpv"]["loudness"] = fmt::format("{}", Data.Mpv.Loudness);
   ini.sections["window"]["save"] = fmt::format("{}", Data.Window.Save);
   ini.sections["window"]["single"] = fmt::format("{}", Data.Window.Single);
+  ini.sections["control"]["enabled"] = fmt::format("{}", Data.Control.Enabled);
+  ini.sections["control"]["address"] = Data.Control.Address;
   ini.sections["window"]["x"] = std::to_string(Data.Window.X);
   ini.sections["window"]["y"] = std::to_string(Data.Window.Y);
   ini.sections["window"]["w"] = std::to_string(Data.Window.W);
   ini.sections["window"]["h"] = std::to_string(Data.Window.H);
   ini.sections["debug"]["log-level"] = Data.Debug.LogLevel;
   ini.sections["debug"]["log-limit"] = std::to_string(Data.Debug.LogLimit);
+  ini.sections["debug"]["log-file"] = fmt::format("{}", Data.Debug.LogFile);
+  ini.sections["debug"]["log-file-size"] = std::to_string(Data.Debug.LogFileSize);
   ini.sections["recent"]["limit"] = std::to_string(Data.Recent.Limit);
   ini.sections["recent"]["space-to-play-last"] = fmt::format("{}", Data.Recent.SpaceToPlayLast);
 
@@ -93,12 +115,14 @@ void Config::save() {
         file.path == file.title ? file.path : fmt::format("{}|{}", file.path, file.title);
   }
 
+  index = 0;
+  for (auto& root : Data.Files.Roots) ini.sections["files"][fmt::format("root-{}", index++)] = root;
+
   std::ofstream file(configFile);
   ini.generate(file);
 }
 
-const ImWchar* Config::buildGlyphRanges() {
-  ImFontAtlas* fonts = ImGui::GetIO().Fonts;
+const ImWchar* Config::buildGlyphRanges(ImFontAtlas* fonts) {
   ImFontGlyphRangesBuilder glyphRangesBuilder;
   static ImVector<ImWchar> glyphRanges;
   glyphRangesBuilder.AddRanges(fonts->GetGlyphRangesDefault());
@@ -109,10 +133,25 @@ const ImWchar* Config::buildGlyphRanges() {
   if (Data.Font.GlyphRange & GlyphRange_Korean) glyphRangesBuilder.AddRanges(fonts->GetGlyphRangesKorean());
   if (Data.Font.GlyphRange & GlyphRange_Thai) glyphRangesBuilder.AddRanges(fonts->GetGlyphRangesThai());
   if (Data.Font.GlyphRange & GlyphRange_Vietnamese) glyphRangesBuilder.AddRanges(fonts->GetGlyphRangesVietnamese());
+  for (int i = 0; i < extraGlyphs.UsedChars.Size; i++) glyphRangesBuilder.UsedChars[i] |= extraGlyphs.UsedChars[i];
   glyphRangesBuilder.BuildRanges(&glyphRanges);
+  loadedGlyphs = glyphRangesBuilder;
+  PendingGlyphs.clear();
   return &glyphRanges[0];
 }
 
+void Config::addGlyphs(std::string_view text) {
+  const char *p = text.data(), *end = p + text.size();
+  while (p < end && (unsigned char)*p < 0x80) p++;
+  while (p < end) {
+    unsigned int c;
+    p += ImTextCharFromUtf8(&c, p, end);
+    if (c < 0x80 || c > IM_UNICODE_CODEPOINT_MAX || extraGlyphs.GetBit(c)) continue;
+    extraGlyphs.SetBit(c);
+    if (!loadedGlyphs.GetBit(c)) PendingGlyphs.push_back((ImWchar)c);
+  }
+}
+
 void Config::addRecentFile(const std::string& path, const std::string& title) {
   if (Data.Recent.Limit == 0) {
     if (recentFiles.size() > 0) recentFiles.clear();
@@ -122,6 +161,7 @@ void Config::addRecentFile(const std::string& path, const std::string& title) {
   auto it = std::find(recentFiles.begin(), recentFiles.end(), item);
   if (it != recentFiles.end()) recentFiles.erase(it);
   recentFiles.insert(recentFiles.begin(), item);
+  addGlyphs(item.title);
   if (recentFiles.size() > Data.Recent.Limit) recentFiles.pop_back();
 }
 
@@ -136,4 +176,38 @@ std::string Config::ipcSocket() {
   return configDir + "/mpv-ipc-socket";
 #endif
 }
+
+std::string Config::handoffSocket() {
+#ifdef _WIN32
+  return "\\\\.\\pipe\\implay-ipc-socket";
+#else
+  return configDir + "/implay-ipc-socket";
+#endif
+}
+
+std::string Config::controlAddress() {
+  if (!Data.Control.Address.empty()) return Data.Control.Address;
+#ifdef _WIN32
+  return "127.0.0.1:9730";
+#else
+  return configDir + "/implay-control-socket";
+#endif
+}
+
+// created on first use, only readable by the user; TCP clients send it to prove they are that user
+std::string Config::controlToken() {
+  auto path = std::filesystem::path(configDir) / "implay-control-token";
+  std::string token;
+  if (std::ifstream in(path); in && std::getline(in, token) && token.size() >= 32) return token;
+
+  std::random_device rd;
+  token = fmt::format("{:08x}{:08x}{:08x}{:08x}", rd(), rd(), rd(), rd());
+  // restrict the file before the token is in it
+  std::ofstream(path, std::ios::trunc).close();
+  std::error_code ec;
+  std::filesystem::permissions(path, std::filesystem::perms::owner_read | std::filesystem::perms::owner_write,
+                               std::filesystem::perm_options::replace, ec);
+  std::ofstream(path, std::ios::trunc) << token << "\n";
+  return token;
+}
 }  // namespace ImPlay
\ No newline at end of file
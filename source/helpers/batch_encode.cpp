@@ -0,0 +1,197 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <set>
+#include <thread>
+#include <fmt/color.h>
+#include <mpv/client.h>
+#include "helpers/batch_encode.h"
+
+namespace ImPlay {
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static std::string formatTime(double seconds) {
+  int s = (int)seconds;
+  return fmt::format("{:02}:{:02}:{:02}", s / 3600, s / 60 % 60, s % 60);
+}
+
+BatchEncoder::BatchEncoder(std::map<std::string, std::string> options, std::string pattern, int jobs)
+    : options(std::move(options)), pattern(std::move(pattern)), jobs(jobs) {
+  // encoders are multithreaded themselves, so one instance per 4 cores keeps them busy
+  if (this->jobs <= 0) this->jobs = std::max(1u, std::thread::hardware_concurrency() / 4);
+  this->options.erase("o");
+}
+
+void BatchEncoder::encode(Job &job) {
+  auto start = job.started;
+  auto fail = [&](std::string error) {
+    std::lock_guard<std::mutex> l(lock);
+    job.state = Job::Failed;
+    job.error = std::move(error);
+    job.elapsed = secondsSince(start);
+  };
+
+  mpv_handle *ctx = mpv_create();
+  if (!ctx) return fail("could not create mpv handle");
+  for (const auto &[key, value] : options) {
+    if (int err = mpv_set_option_string(ctx, key.c_str(), value.c_str()); err < 0) {
+      mpv_terminate_destroy(ctx);
+      return fail(fmt::format("{} [{}={}]", mpv_error_string(err), key, value));
+    }
+  }
+  mpv_set_option_string(ctx, "o", job.output.c_str());
+  mpv_set_option_string(ctx, "idle", "yes");
+  if (mpv_initialize(ctx) < 0) {
+    mpv_terminate_destroy(ctx);
+    return fail("could not initialize mpv context");
+  }
+  mpv_observe_property(ctx, 0, "percent-pos", MPV_FORMAT_DOUBLE);
+  mpv_observe_property(ctx, 0, "duration", MPV_FORMAT_DOUBLE);
+
+  const char *cmd[] = {"loadfile", job.input.c_str(), nullptr};
+  mpv_command(ctx, cmd);
+
+  std::string error;
+  bool ended = false;
+  while (!ended) {
+    mpv_event *event = mpv_wait_event(ctx, -1);
+    switch (event->event_id) {
+      case MPV_EVENT_PROPERTY_CHANGE: {
+        auto prop = (mpv_event_property *)event->data;
+        if (prop->format != MPV_FORMAT_DOUBLE) break;
+        std::lock_guard<std::mutex> l(lock);
+        if (strcmp(prop->name, "percent-pos") == 0) job.percent = *(double *)prop->data;
+        if (strcmp(prop->name, "duration") == 0) job.duration = *(double *)prop->data;
+        break;
+      }
+      case MPV_EVENT_END_FILE: {
+        auto ef = (mpv_event_end_file *)event->data;
+        if (ef->reason == MPV_END_FILE_REASON_ERROR) error = mpv_error_string(ef->error);
+        ended = true;
+        break;
+      }
+      case MPV_EVENT_SHUTDOWN:
+        if (error.empty()) error = "mpv quit before the file ended";
+        ended = true;
+        break;
+      default:
+        break;
+    }
+  }
+  // finishes writing the output
+  mpv_terminate_destroy(ctx);
+
+  if (!error.empty()) return fail(error);
+  std::lock_guard<std::mutex> l(lock);
+  job.state = Job::Done;
+  job.percent = 100;
+  job.elapsed = secondsSince(start);
+}
+
+void BatchEncoder::printProgress(double elapsed) {
+  std::lock_guard<std::mutex> l(lock);
+  size_t done = 0;
+  for (auto &job : queue)
+    if (job.state == Job::Done || job.state == Job::Failed) done++;
+  fmt::print(stderr, "[{}] {}/{} done\n", formatTime(elapsed), done, queue.size());
+  for (auto &job : queue) {
+    if (job.state != Job::Running) continue;
+    job.elapsed = secondsSince(job.started);
+    double eta = job.percent > 0 ? job.elapsed * (100 - job.percent) / job.percent : 0;
+    auto name = std::filesystem::u8path(job.input).filename().u8string();
+    fmt::print(stderr, "  {:5.1f}%  eta {}  {}\n", job.percent, job.percent > 0 ? formatTime(eta) : "--:--:--",
+               std::string(name.begin(), name.end()));
+  }
+}
+
+nlohmann::json BatchEncoder::run(const std::vector<std::string> &inputs) {
+  std::set<std::string> outputs;
+  for (size_t i = 0; i < inputs.size(); i++) {
+    auto &job = queue.emplace_back();
+    job.input = inputs[i];
+    auto path = std::filesystem::u8path(inputs[i]);
+    auto name = path.stem().u8string(), dir = path.parent_path().u8string();
+    try {
+      job.output = fmt::format(fmt::runtime(pattern), fmt::arg("name", std::string(name.begin(), name.end())),
+                               fmt::arg("dir", dir.empty() ? "." : std::string(dir.begin(), dir.end())),
+                               fmt::arg("index", i + 1));
+    } catch (const fmt::format_error &e) {
+      job.state = Job::Failed;
+      job.error = fmt::format("invalid output pattern: {}", e.what());
+      continue;
+    }
+    // two inputs writing the same output would overwrite each other
+    if (!outputs.insert(job.output).second) {
+      job.state = Job::Failed;
+      job.error = fmt::format("output {} is used by an earlier input", job.output);
+    }
+  }
+
+  auto start = Clock::now();
+  std::atomic<size_t> next = 0;
+  std::vector<std::thread> workers;
+  for (int i = 0; i < std::min<int>(jobs, (int)queue.size()); i++) {
+    workers.emplace_back([&]() {
+      for (size_t n = next++; n < queue.size(); n = next++) {
+        {
+          std::lock_guard<std::mutex> l(lock);
+          if (queue[n].state != Job::Queued) continue;
+          queue[n].state = Job::Running;
+          queue[n].started = Clock::now();
+        }
+        encode(queue[n]);
+      }
+    });
+  }
+
+  std::atomic<bool> finished = false;
+  std::thread reporter([&]() {
+    auto last = Clock::now();
+    while (!finished) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      if (Clock::now() - last < std::chrono::seconds(2)) continue;
+      last = Clock::now();
+      printProgress(secondsSince(start));
+    }
+  });
+  for (auto &worker : workers) worker.join();
+  finished = true;
+  reporter.join();
+
+  double wallTime = secondsSince(start), mediaTime = 0;
+  size_t failed = 0;
+  auto files = nlohmann::json::array();
+  for (auto &job : queue) {
+    nlohmann::json file = {{"input", job.input}, {"output", job.output}, {"elapsed", job.elapsed}};
+    if (job.state == Job::Done) {
+      mediaTime += job.duration;
+      file["status"] = "ok";
+      file["duration"] = job.duration;
+      file["speed"] = job.elapsed > 0 ? job.duration / job.elapsed : 0;
+    } else {
+      failed++;
+      file["status"] = "failed";
+      file["error"] = job.error;
+    }
+    files.push_back(file);
+  }
+  return {
+      {"jobs", std::min<int>(jobs, (int)queue.size())},
+      {"wall_time", wallTime},
+      {"media_time", mediaTime},
+      {"speed", wallTime > 0 ? mediaTime / wallTime : 0},
+      {"succeeded", queue.size() - failed},
+      {"failed", failed},
+      {"files", files},
+  };
+}
+}  // namespace ImPlay
@@ -0,0 +1,288 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#define poll WSAPoll
+#define closeSocket closesocket
+#else
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define closeSocket close
+#endif
+#include "helpers/control_server.h"
+
+namespace ImPlay {
+#ifdef MSG_NOSIGNAL
+constexpr int SendFlags = MSG_NOSIGNAL;
+#else
+constexpr int SendFlags = 0;
+#endif
+
+static void setNonBlocking(intptr_t fd) {
+#ifdef _WIN32
+  u_long on = 1;
+  ioctlsocket((SOCKET)fd, FIONBIO, &on);
+#else
+  fcntl((int)fd, F_SETFL, fcntl((int)fd, F_GETFL) | O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+  int on = 1;
+  setsockopt((int)fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+#endif
+}
+
+#ifndef _WIN32
+// the socket file is open to anyone between bind() and chmod(), so the peer is checked too
+static bool sameUser(int fd) {
+#ifdef SO_PEERCRED
+  ucred cred{};
+  socklen_t len = sizeof(cred);
+  return getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0 && cred.uid == geteuid();
+#else
+  uid_t uid;
+  gid_t gid;
+  return getpeereid(fd, &uid, &gid) == 0 && uid == geteuid();
+#endif
+}
+#endif
+
+ControlServer::ControlServer(std::string address, std::string token, CommandHandler handler)
+    : address(std::move(address)), token(std::move(token)), handler(std::move(handler)) {}
+
+ControlServer::~ControlServer() {
+  quit = true;
+  if (thread.joinable()) thread.join();
+  for (auto &client : clients) closeSocket(client.fd);
+  if (listenFd != -1) closeSocket(listenFd);
+#ifndef _WIN32
+  if (unixSocket && listenFd != -1) unlink(address.c_str());
+#endif
+}
+
+// host:port is TCP, restricted to loopback addresses; anything else is a socket path
+bool ControlServer::start() {
+  auto colon = address.rfind(':');
+  bool tcp = colon != std::string::npos && colon + 1 < address.size() &&
+             std::all_of(address.begin() + colon + 1, address.end(), ::isdigit);
+#ifdef _WIN32
+  WSADATA wsa;
+  if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0 || !tcp) return false;
+#endif
+
+  if (tcp) {
+    std::string host = address.substr(0, colon), port = address.substr(colon + 1);
+    if (host.empty()) host = "127.0.0.1";
+    addrinfo hints{}, *res = nullptr;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0 || res == nullptr) return false;
+    bool loopback = res->ai_family == AF_INET
+                        ? (ntohl(((sockaddr_in *)res->ai_addr)->sin_addr.s_addr) >> 24) == 127
+                        : memcmp(&((sockaddr_in6 *)res->ai_addr)->sin6_addr, &in6addr_loopback, sizeof(in6_addr)) == 0;
+    if (loopback) {
+      listenFd = (intptr_t)socket(res->ai_family, SOCK_STREAM, 0);
+      int on = 1;
+      setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, (const char *)&on, sizeof(on));
+      if (listenFd != -1 && bind(listenFd, res->ai_addr, (int)res->ai_addrlen) != 0) {
+        closeSocket(listenFd);
+        listenFd = -1;
+      }
+    }
+    freeaddrinfo(res);
+  } else {
+#ifndef _WIN32
+    sockaddr_un addr{};
+    if (address.size() >= sizeof(addr.sun_path)) return false;
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, address.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(address.c_str());
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    // connecting needs write access, only the user keeps it
+    if (listenFd != -1 && (bind(listenFd, (sockaddr *)&addr, sizeof(addr)) != 0 || chmod(address.c_str(), 0600) != 0)) {
+      closeSocket(listenFd);
+      listenFd = -1;
+    }
+    unixSocket = true;
+#endif
+  }
+  if (listenFd == -1) return false;
+  if (listen(listenFd, 16) != 0) {
+    closeSocket(listenFd);
+    listenFd = -1;
+    return false;
+  }
+  setNonBlocking(listenFd);
+  thread = std::thread(&ControlServer::serve, this);
+  return true;
+}
+
+void ControlServer::publish(const std::string &key, nlohmann::json value) {
+  std::lock_guard<std::mutex> l(lock);
+  auto &entry = state[key];
+  if (entry.second != 0 && entry.first == value) return;
+  entry = {std::move(value), ++version};
+}
+
+nlohmann::json ControlServer::snapshot(const std::vector<std::string> &keys, Client *client) {
+  auto data = nlohmann::json::object();
+  std::lock_guard<std::mutex> l(lock);
+  auto add = [&](const std::string &key, const std::pair<nlohmann::json, uint64_t> &entry) {
+    data[key] = entry.first;
+    if (client != nullptr) client->sent[key] = entry.second;
+  };
+  if (keys.empty()) {
+    for (auto &[key, entry] : state) add(key, entry);
+  } else {
+    for (auto &key : keys)
+      if (auto it = state.find(key); it != state.end()) add(key, it->second);
+  }
+  return data;
+}
+
+void ControlServer::push(Client &client) {
+  auto data = nlohmann::json::object();
+  {
+    std::lock_guard<std::mutex> l(lock);
+    for (auto &[key, entry] : state) {
+      if (!client.keys.empty() && std::find(client.keys.begin(), client.keys.end(), key) == client.keys.end())
+        continue;
+      auto &sent = client.sent[key];
+      if (sent == entry.second) continue;
+      data[key] = entry.first;
+      sent = entry.second;
+    }
+  }
+  if (!data.empty()) client.out += nlohmann::json{{"event", "update"}, {"data", data}}.dump() + "\n";
+}
+
+void ControlServer::handle(Client &client, const std::string &line) {
+  nlohmann::json reply;
+  auto req = nlohmann::json::parse(line, nullptr, false);
+  if (req.is_discarded() || !req.is_object()) {
+    client.out += nlohmann::json{{"error", "invalid request"}}.dump() + "\n";
+    return;
+  }
+  if (req.contains("id")) reply["id"] = req["id"];
+  if (!client.authorized && req["token"].is_string() && req["token"].get<std::string>() == token)
+    client.authorized = true;
+  if (!client.authorized) {
+    reply["error"] = "unauthorized";
+    client.out += reply.dump() + "\n";
+    return;
+  }
+  auto keys = [&](const char *name) {
+    std::vector<std::string> list;
+    if (req[name].is_array())
+      for (auto &key : req[name])
+        if (key.is_string()) list.push_back(key.get<std::string>());
+    return list;
+  };
+
+  if (req.contains("commands") && req["commands"].is_array()) {
+    auto results = nlohmann::json::array();
+    for (auto &cmd : req["commands"]) {
+      std::vector<std::string> args;
+      if (cmd.is_array())
+        for (auto &arg : cmd) args.push_back(arg.is_string() ? arg.get<std::string>() : arg.dump());
+      results.push_back(args.empty() ? "invalid command" : handler(args));
+    }
+    reply["results"] = results;
+  } else if (req.contains("get")) {
+    reply["data"] = snapshot(keys("get"));
+  } else if (req.contains("subscribe")) {
+    client.subscribed = true;
+    client.keys = keys("subscribe");
+    client.sent.clear();
+    reply["data"] = snapshot(client.keys, &client);
+  } else if (req.contains("unsubscribe")) {
+    client.subscribed = false;
+    reply["data"] = nullptr;
+  } else if (req.contains("token")) {
+    reply["data"] = nullptr;
+  } else {
+    reply["error"] = "unknown request";
+  }
+  client.out += reply.dump() + "\n";
+}
+
+void ControlServer::serve() {
+  std::vector<pollfd> fds;
+  uint64_t pushed = 0;
+  auto lastPush = std::chrono::steady_clock::now();
+  while (!quit) {
+    fds.clear();
+    fds.push_back({(decltype(pollfd::fd))listenFd, POLLIN, 0});
+    for (auto &client : clients)
+      fds.push_back({(decltype(pollfd::fd))client.fd, (short)(POLLIN | (client.out.empty() ? 0 : POLLOUT)), 0});
+    // the timeout doubles as the push interval and the quit check
+    if (poll(fds.data(), (unsigned long)fds.size(), PushIntervalMs) < 0) continue;
+
+    if (fds[0].revents & POLLIN) {
+      intptr_t fd = (intptr_t)accept(listenFd, nullptr, nullptr);
+#ifndef _WIN32
+      if (fd != -1 && unixSocket && !sameUser((int)fd)) {
+        closeSocket(fd);
+        fd = -1;
+      }
+#endif
+      if (fd != -1) {
+        setNonBlocking(fd);
+        clients.push_back({fd});
+        clients.back().authorized = unixSocket;
+      }
+    }
+
+    for (size_t i = 1; i < fds.size(); i++) {
+      auto &client = clients[i - 1];
+      bool closed = fds[i].revents & (POLLERR | POLLHUP | POLLNVAL);
+      if (fds[i].revents & POLLIN) {
+        char buf[4096];
+        auto n = recv(client.fd, buf, sizeof(buf), 0);
+        if (n <= 0)
+          closed = true;
+        else
+          client.in.append(buf, n);
+        size_t start = 0, end;
+        while ((end = client.in.find('\n', start)) != std::string::npos) {
+          handle(client, client.in.substr(start, end - start));
+          start = end + 1;
+        }
+        client.in.erase(0, start);
+      }
+      if (!client.out.empty()) {
+        auto n = send(client.fd, client.out.data(), (int)client.out.size(), SendFlags);
+        if (n > 0) client.out.erase(0, n);
+      }
+      if (client.in.size() > MaxBuffer || client.out.size() > MaxBuffer) closed = true;
+      if (closed) {
+        closeSocket(client.fd);
+        client.fd = -1;
+      }
+    }
+    clients.erase(std::remove_if(clients.begin(), clients.end(), [](auto &c) { return c.fd == -1; }), clients.end());
+
+    uint64_t current;
+    {
+      std::lock_guard<std::mutex> l(lock);
+      current = version;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (current != pushed && now - lastPush >= std::chrono::milliseconds(PushIntervalMs)) {
+      for (auto &client : clients)
+        if (client.subscribed) push(client);
+      pushed = current;
+      lastPush = now;
+    }
+  }
+}
+}  // namespace ImPlay
@@ -0,0 +1,235 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include "helpers/file_search.h"
+#include "helpers/fuzzy.h"
+
+namespace ImPlay {
+using Clock = std::chrono::steady_clock;
+constexpr auto PublishInterval = std::chrono::milliseconds(50);
+constexpr auto MaxAge = std::chrono::seconds(60);  // before refresh() walks again
+constexpr size_t ChunkSize = 1024;
+
+namespace {
+struct Entry {
+  std::string path;
+  std::string name;
+  std::string folded;  // name
+  Fuzzy::Key key;      // path below its root
+};
+using Chunk = std::vector<Entry>;
+}  // namespace
+
+struct FileSearch::State {
+  std::mutex lock;
+  std::condition_variable cond;
+  bool quit = false;
+
+  // the walk appends chunks, a new walk replaces them
+  std::vector<std::filesystem::path> roots;
+  std::atomic<uint64_t> walkGen = 0;
+  bool walking = false, stale = true;
+  Clock::time_point walked;
+  std::vector<std::shared_ptr<const Chunk>> chunks;
+
+  // the query, matched against all chunks so far while active
+  std::atomic<uint64_t> generation = 0;
+  std::string query;
+  Filter filter;
+  bool active = false, busy = false;
+
+  std::vector<Result> snapshot;
+  bool changed = false;
+};
+
+// best result first; the matcher keeps a min-heap with the worst result on top
+static bool better(const FileSearch::Result &a, const FileSearch::Result &b) {
+  if (a.score != b.score) return a.score > b.score;
+  return a.path < b.path;
+}
+
+FileSearch::FileSearch() : state(std::make_shared<State>()) { matcher = std::thread(&FileSearch::match, this); }
+
+FileSearch::~FileSearch() {
+  {
+    std::lock_guard<std::mutex> l(state->lock);
+    state->quit = true;
+    state->generation++;
+    state->walkGen++;
+  }
+  state->cond.notify_all();
+  matcher.join();
+}
+
+void FileSearch::start(std::vector<std::filesystem::path> roots, std::string query, Filter filter) {
+  std::lock_guard<std::mutex> l(state->lock);
+  if (state->stale || roots != state->roots) {
+    state->roots = roots;
+    state->stale = false;
+    state->walking = true;
+    state->chunks.clear();
+    std::thread(&FileSearch::walk, state, ++state->walkGen, std::move(roots)).detach();
+  }
+  state->generation++;
+  state->query = std::move(query);
+  state->filter = std::move(filter);
+  state->active = true;
+  state->busy = true;
+  state->cond.notify_all();
+}
+
+void FileSearch::cancel() {
+  std::lock_guard<std::mutex> l(state->lock);
+  state->generation++;
+  state->active = false;
+  state->busy = false;
+}
+
+void FileSearch::refresh() {
+  std::lock_guard<std::mutex> l(state->lock);
+  if (!state->walking && Clock::now() - state->walked >= MaxAge) state->stale = true;
+}
+
+bool FileSearch::poll(std::vector<Result> &results) {
+  std::lock_guard<std::mutex> l(state->lock);
+  if (!state->changed) return false;
+  results = state->snapshot;
+  state->changed = false;
+  return true;
+}
+
+bool FileSearch::running() const {
+  std::lock_guard<std::mutex> l(state->lock);
+  return state->busy;
+}
+
+// detached: it only touches the shared state, and stops at the next entry once superseded
+void FileSearch::walk(std::shared_ptr<State> state, uint64_t gen, std::vector<std::filesystem::path> roots) {
+  namespace fs = std::filesystem;
+  auto chunk = std::make_shared<Chunk>();
+  auto lastFlush = Clock::now();
+  auto flush = [&]() {
+    std::lock_guard<std::mutex> l(state->lock);
+    if (gen != state->walkGen) return false;
+    if (!chunk->empty()) state->chunks.push_back(std::move(chunk));
+    chunk = std::make_shared<Chunk>();
+    lastFlush = Clock::now();
+    state->cond.notify_all();
+    return true;
+  };
+
+  for (auto &root : roots) {
+    std::error_code ec;
+    size_t prefix = root.u8string().size();
+    auto it = fs::recursive_directory_iterator(root, fs::directory_options::skip_permission_denied, ec);
+    for (; !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+      if (gen != state->walkGen) return;
+
+      std::error_code err;
+      auto name = it->path().filename().u8string();
+      std::string filename(name.begin(), name.end());
+      if (filename.starts_with(".")) {
+        if (it->is_directory(err)) it.disable_recursion_pending();
+        continue;
+      }
+      if (!it->is_regular_file(err)) continue;
+
+      auto u8path = it->path().u8string();
+      std::string path(u8path.begin(), u8path.end());
+      Fuzzy::Key key(path.substr(std::min(path.size(), prefix)));
+      auto folded = Fuzzy::fold(filename);
+      chunk->push_back({std::move(path), std::move(filename), std::move(folded), std::move(key)});
+      if ((chunk->size() >= ChunkSize || Clock::now() - lastFlush >= PublishInterval) && !flush()) return;
+    }
+  }
+
+  if (!flush()) return;
+  std::lock_guard<std::mutex> l(state->lock);
+  state->walking = false;
+  state->walked = Clock::now();
+  state->cond.notify_all();
+}
+
+void FileSearch::match() {
+  std::unique_lock<std::mutex> l(state->lock);
+  uint64_t gen = 0, walkGen = 0;
+  size_t next = 0;  // the first chunk not matched yet
+  std::string query;
+  Filter filter;
+  uint64_t mask = 0;
+  std::vector<Result> heap;
+  bool final = false;  // the published results are complete
+
+  while (true) {
+    state->cond.wait(l, [&]() {
+      if (state->quit) return true;
+      if (!state->active) return false;
+      return state->generation != gen || state->walkGen != walkGen || next < state->chunks.size() ||
+             (state->busy && !state->walking);
+    });
+    if (state->quit) break;
+    if (state->generation != gen || state->walkGen != walkGen) {
+      gen = state->generation;
+      walkGen = state->walkGen;
+      query = state->query;
+      filter = state->filter;
+      mask = Fuzzy::charMask(query);
+      heap.clear();
+      next = 0;
+      final = false;
+    }
+    std::vector<std::shared_ptr<const Chunk>> todo(state->chunks.begin() + next, state->chunks.end());
+    next = state->chunks.size();
+    l.unlock();
+
+    bool dirty = false;
+    for (auto &chunk : todo) {
+      if (gen != state->generation) break;
+      for (auto &entry : *chunk) {
+        if ((entry.key.mask & mask) != mask || (filter && !filter(entry.name))) continue;
+
+        int score = 1;
+        if (mask != 0) {
+          score = Fuzzy::score(query, entry.folded) * 2;
+          if (score == 0) score = Fuzzy::score(query, entry.key.str);
+          if (score == 0) continue;
+        }
+
+        Result result{entry.path, entry.name, score};
+        if (heap.size() < Limit) {
+          heap.push_back(std::move(result));
+          std::push_heap(heap.begin(), heap.end(), better);
+        } else if (better(result, heap.front())) {
+          std::pop_heap(heap.begin(), heap.end(), better);
+          heap.back() = std::move(result);
+          std::push_heap(heap.begin(), heap.end(), better);
+        } else {
+          continue;
+        }
+        dirty = true;
+      }
+    }
+
+    std::vector<Result> sorted = heap;
+    std::sort(sorted.begin(), sorted.end(), better);
+
+    l.lock();
+    if (gen != state->generation || walkGen != state->walkGen) continue;
+    // caught up with a finished walk, the results are final even if empty
+    bool done = next == state->chunks.size() && !state->walking;
+    if (dirty || (done && !final)) {
+      state->snapshot = std::move(sorted);
+      state->changed = true;
+    }
+    if (done) {
+      final = true;
+      state->busy = false;
+    }
+  }
+}
+}  // namespace ImPlay
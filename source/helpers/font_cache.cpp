@@ -0,0 +1,208 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <vector>
+#include <fmt/format.h>
+#include "helpers/font_cache.h"
+#include "helpers/mapped_file.h"
+#include "helpers/utils.h"
+
+namespace ImPlay {
+constexpr char Magic[4] = {'I', 'P', 'F', 'A'};
+constexpr uint32_t Version = 1;
+constexpr size_t MaxFiles = 4;  // the most recently written atlases, e.g. one per monitor scale
+
+namespace {
+struct Writer {
+  std::string buf;
+
+  void put(const void *data, size_t size) { buf.append((const char *)data, size); }
+  template <typename T>
+  void put(const T &value) {
+    put(&value, sizeof(T));
+  }
+  template <typename T>
+  void put(const ImVector<T> &vec) {
+    put((uint32_t)vec.Size);
+    put(vec.Data, vec.size_in_bytes());
+  }
+};
+
+struct Reader {
+  const char *data;
+  size_t size;
+  size_t pos = 0;
+
+  bool get(void *out, size_t n) {
+    if (n > size - pos) return false;
+    memcpy(out, data + pos, n);
+    pos += n;
+    return true;
+  }
+  template <typename T>
+  bool get(T &value) {
+    return get(&value, sizeof(T));
+  }
+  template <typename T>
+  bool get(ImVector<T> &vec) {
+    uint32_t n;
+    if (!get(n) || n > (size - pos) / sizeof(T)) return false;
+    vec.resize((int)n);
+    return get(vec.Data, n * sizeof(T));
+  }
+  bool pixels(unsigned char **out, size_t n) {
+    uint8_t has;
+    if (!get(has)) return false;
+    if (!has) return true;
+    *out = (unsigned char *)IM_ALLOC(n);
+    return get(*out, n);
+  }
+};
+}  // namespace
+
+void FontCache::add(const void *data, size_t size) {
+  auto p = (const unsigned char *)data;
+  for (size_t i = 0; i < size; i++) {
+    key ^= p[i];
+    key *= 1099511628211ull;
+  }
+}
+
+void FontCache::add(const ImWchar *ranges) {
+  if (ranges == nullptr) return add((ImWchar)0);
+  size_t n = 0;
+  while (ranges[n] != 0) n++;
+  add(ranges, n * sizeof(ImWchar));
+}
+
+void FontCache::addFile(const std::string &path) {
+  std::error_code ec;
+  auto p = std::filesystem::u8path(path);
+  add(path);
+  add((uint64_t)std::filesystem::file_size(p, ec));
+  add((int64_t)std::filesystem::last_write_time(p, ec).time_since_epoch().count());
+}
+
+std::filesystem::path FontCache::path() const { return dir / fmt::format("{:016x}.bin", key); }
+
+bool FontCache::load(ImFontAtlas *atlas) const {
+  std::unique_ptr<MappedFile> file;
+  try {
+    file = std::make_unique<MappedFile>(path());
+  } catch (const std::exception &) {
+    return false;
+  }
+
+  Reader r{file->data(), file->size()};
+  char magic[4];
+  uint32_t version;
+  uint64_t fileKey;
+  if (!r.get(magic) || memcmp(magic, Magic, sizeof(Magic)) != 0) return false;
+  if (!r.get(version) || version != Version || !r.get(fileKey) || fileKey != key) return false;
+
+  auto fail = [&]() {
+    atlas->Clear();
+    return false;
+  };
+
+  atlas->Clear();
+  ImVector<int> rectFonts;
+  uint32_t fontCount;
+  if (!r.get(atlas->TexWidth) || !r.get(atlas->TexHeight) || !r.get(atlas->TexUvScale) ||
+      !r.get(atlas->TexUvWhitePixel) || !r.get(atlas->TexUvLines) || !r.get(atlas->PackIdMouseCursors) ||
+      !r.get(atlas->PackIdLines) || !r.get(atlas->ShadowRectIds) || !r.get(atlas->ShadowRectUvs) ||
+      !r.get(atlas->TexPixelsUseColors) || !r.get(atlas->CustomRects) || !r.get(rectFonts) || !r.get(fontCount))
+    return fail();
+  if (atlas->TexWidth <= 0 || atlas->TexHeight <= 0 || rectFonts.Size != atlas->CustomRects.Size) return fail();
+
+  for (uint32_t i = 0; i < fontCount; i++) {
+    ImFont *font = IM_NEW(ImFont);
+    atlas->Fonts.push_back(font);
+    font->ContainerAtlas = atlas;
+    if (!r.get(font->FontSize) || !r.get(font->Scale) || !r.get(font->Ascent) || !r.get(font->Descent) ||
+        !r.get(font->FallbackChar) || !r.get(font->EllipsisChar) || !r.get(font->MetricsTotalSurface) ||
+        !r.get(font->Glyphs) || font->Glyphs.empty())
+      return fail();
+    font->BuildLookupTable();
+  }
+  for (int i = 0; i < rectFonts.Size; i++) {
+    if (rectFonts[i] >= (int)fontCount) return fail();
+    atlas->CustomRects[i].Font = rectFonts[i] >= 0 ? atlas->Fonts[rectFonts[i]] : nullptr;
+  }
+
+  size_t pixels = (size_t)atlas->TexWidth * atlas->TexHeight;
+  if (!r.pixels(&atlas->TexPixelsAlpha8, pixels) || !r.pixels((unsigned char **)&atlas->TexPixelsRGBA32, pixels * 4))
+    return fail();
+  if (atlas->TexPixelsAlpha8 == nullptr && atlas->TexPixelsRGBA32 == nullptr) return fail();
+
+  atlas->TexReady = true;
+  return true;
+}
+
+bool FontCache::save(const ImFontAtlas *atlas) const {
+  if (!atlas->IsBuilt()) return false;
+
+  Writer w;
+  w.put(Magic);
+  w.put(Version);
+  w.put(key);
+
+  // custom rects point to their target font, store it as an index
+  ImVector<int> rectFonts;
+  for (auto &rect : atlas->CustomRects) {
+    auto it = std::find(atlas->Fonts.begin(), atlas->Fonts.end(), rect.Font);
+    rectFonts.push_back(it != atlas->Fonts.end() ? atlas->Fonts.index_from_ptr(it) : -1);
+  }
+  w.put(atlas->TexWidth);
+  w.put(atlas->TexHeight);
+  w.put(atlas->TexUvScale);
+  w.put(atlas->TexUvWhitePixel);
+  w.put(atlas->TexUvLines);
+  w.put(atlas->PackIdMouseCursors);
+  w.put(atlas->PackIdLines);
+  w.put(atlas->ShadowRectIds);
+  w.put(atlas->ShadowRectUvs);
+  w.put(atlas->TexPixelsUseColors);
+  w.put(atlas->CustomRects);
+  w.put(rectFonts);
+
+  w.put((uint32_t)atlas->Fonts.Size);
+  for (auto font : atlas->Fonts) {
+    w.put(font->FontSize);
+    w.put(font->Scale);
+    w.put(font->Ascent);
+    w.put(font->Descent);
+    w.put(font->FallbackChar);
+    w.put(font->EllipsisChar);
+    w.put(font->MetricsTotalSurface);
+    w.put(font->Glyphs);
+  }
+
+  size_t pixels = (size_t)atlas->TexWidth * atlas->TexHeight;
+  w.put((uint8_t)(atlas->TexPixelsAlpha8 != nullptr));
+  if (atlas->TexPixelsAlpha8 != nullptr) w.put(atlas->TexPixelsAlpha8, pixels);
+  w.put((uint8_t)(atlas->TexPixelsRGBA32 != nullptr));
+  if (atlas->TexPixelsRGBA32 != nullptr) w.put(atlas->TexPixelsRGBA32, pixels * 4);
+
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+  auto file = path();
+  auto tmp = file;
+  tmp += ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out || !out.write(w.buf.data(), w.buf.size())) return false;
+  }
+  std::filesystem::rename(tmp, file, ec);
+  if (ec) {
+    std::filesystem::remove(tmp, ec);
+    return false;
+  }
+  prune(dir, ".bin", MaxFiles);
+  return true;
+}
+}  // namespace ImPlay
@@ -0,0 +1,161 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <algorithm>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FUZZY_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define FUZZY_NEON
+#endif
+#include "helpers/fuzzy.h"
+
+namespace ImPlay::Fuzzy {
+// scoring constants borrowed from fzf's v1 algorithm
+constexpr int ScoreMatch = 16;
+constexpr int PenaltyGapStart = -3;
+constexpr int PenaltyGapExtension = -1;
+constexpr int BonusBoundary = ScoreMatch / 2;
+constexpr int BonusNonWord = ScoreMatch / 2;
+constexpr int BonusConsecutive = -(PenaltyGapStart + PenaltyGapExtension);
+constexpr int BonusFirstCharMultiplier = 2;
+
+Key::Key(std::string_view text) : str(fold(text)) { mask = charMask(str); }
+
+std::string fold(std::string_view text) {
+  std::string out(text);
+  size_t i = 0;
+  char *p = out.data();
+#if defined(FUZZY_SSE2)
+  const __m128i lo = _mm_set1_epi8('A' - 1);
+  const __m128i hi = _mm_set1_epi8('Z' + 1);
+  const __m128i bit = _mm_set1_epi8(0x20);
+  for (; i + 16 <= out.size(); i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+    __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, lo), _mm_cmplt_epi8(v, hi));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p + i), _mm_or_si128(v, _mm_and_si128(upper, bit)));
+  }
+#elif defined(FUZZY_NEON)
+  const uint8x16_t lo = vdupq_n_u8('A');
+  const uint8x16_t hi = vdupq_n_u8('Z');
+  const uint8x16_t bit = vdupq_n_u8(0x20);
+  for (; i + 16 <= out.size(); i += 16) {
+    uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(p + i));
+    uint8x16_t upper = vandq_u8(vcgeq_u8(v, lo), vcleq_u8(v, hi));
+    vst1q_u8(reinterpret_cast<uint8_t *>(p + i), vorrq_u8(v, vandq_u8(upper, bit)));
+  }
+#endif
+  for (; i < out.size(); i++)
+    if (p[i] >= 'A' && p[i] <= 'Z') p[i] |= 0x20;
+  return out;
+}
+
+uint64_t charMask(std::string_view folded) {
+  uint64_t mask = 0;
+  for (unsigned char c : folded) {
+    if (c >= 'a' && c <= 'z')
+      mask |= 1ull << (c - 'a');
+    else if (c >= '0' && c <= '9')
+      mask |= 1ull << (26 + c - '0');
+    else if (c >= 0x80)
+      mask |= 1ull << (48 + (c & 0x0F));
+    else if (c != ' ')
+      mask |= 1ull << (36 + c % 12);
+  }
+  return mask;
+}
+
+static inline bool isWord(unsigned char c) {
+  return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+}
+
+static inline int bonusAt(std::string_view text, size_t i) {
+  unsigned char c = text[i];
+  if (!isWord(c)) return BonusNonWord;
+  if (i == 0 || !isWord(text[i - 1])) return BonusBoundary;
+  return 0;
+}
+
+static int scoreTerm(std::string_view pattern, std::string_view text) {
+  if (pattern.size() > text.size()) return 0;
+
+  // find the first occurrence of the subsequence, then walk back from its end
+  // to pick the shortest window that still contains the whole pattern.
+  size_t p = 0, start = 0, end = std::string_view::npos;
+  for (size_t i = 0; i < text.size(); i++) {
+    if (text[i] == pattern[p] && ++p == pattern.size()) {
+      end = i;
+      break;
+    }
+  }
+  if (end == std::string_view::npos) return 0;
+  for (size_t i = end + 1; i-- > 0;) {
+    if (text[i] == pattern[p - 1] && --p == 0) {
+      start = i;
+      break;
+    }
+  }
+
+  int score = 0, consecutive = 0, firstBonus = 0;
+  bool inGap = false;
+  for (size_t i = start; i <= end; i++) {
+    if (text[i] == pattern[p]) {
+      int bonus = bonusAt(text, i);
+      if (consecutive == 0) {
+        firstBonus = bonus;
+      } else {
+        if (bonus == BonusBoundary) firstBonus = bonus;
+        bonus = std::max({bonus, firstBonus, BonusConsecutive});
+      }
+      score += ScoreMatch + (p == 0 ? bonus * BonusFirstCharMultiplier : bonus);
+      consecutive++;
+      inGap = false;
+      p++;
+    } else {
+      score += inGap ? PenaltyGapExtension : PenaltyGapStart;
+      consecutive = 0;
+      inGap = true;
+    }
+  }
+  return std::max(score, 1);
+}
+
+int score(std::string_view pattern, std::string_view text) {
+  int total = 0;
+  size_t pos = 0;
+  while (pos < pattern.size()) {
+    size_t next = pattern.find(' ', pos);
+    if (next == std::string_view::npos) next = pattern.size();
+    if (next > pos) {
+      int s = scoreTerm(pattern.substr(pos, next - pos), text);
+      if (s == 0) return 0;
+      total += s;
+    }
+    pos = next + 1;
+  }
+  return std::max(total, 1);
+}
+
+void prefilter(uint64_t mask, const uint64_t *masks, size_t count, std::vector<uint32_t> &out) {
+  size_t i = 0;
+#if defined(FUZZY_SSE2)
+  const __m128i q = _mm_set1_epi64x(static_cast<long long>(mask));
+  for (; i + 2 <= count; i += 2) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(masks + i));
+    int m = _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(v, q), q));
+    if ((m & 0x00FF) == 0x00FF) out.push_back(static_cast<uint32_t>(i));
+    if ((m & 0xFF00) == 0xFF00) out.push_back(static_cast<uint32_t>(i + 1));
+  }
+#elif defined(FUZZY_NEON)
+  const uint64x2_t q = vdupq_n_u64(mask);
+  for (; i + 2 <= count; i += 2) {
+    uint64x2_t m = vceqq_u64(vandq_u64(vld1q_u64(masks + i), q), q);
+    if (vgetq_lane_u64(m, 0)) out.push_back(static_cast<uint32_t>(i));
+    if (vgetq_lane_u64(m, 1)) out.push_back(static_cast<uint32_t>(i + 1));
+  }
+#endif
+  for (; i < count; i++)
+    if ((masks[i] & mask) == mask) out.push_back(static_cast<uint32_t>(i));
+}
+}  // namespace ImPlay::Fuzzy
@@ -0,0 +1,133 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <algorithm>
+#include <cstdint>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include <imgui_internal.h>
+#ifdef IMGUI_IMPL_OPENGL_ES3
+#include <GLES3/gl3.h>
+#else
+#include <GL/gl.h>
+#endif
+#include "helpers/glyph_loader.h"
+
+namespace ImPlay {
+GlyphLoader::~GlyphLoader() { close(); }
+
+void GlyphLoader::reserve(ImFontAtlas *atlas, float size) {
+  IM_ASSERT(atlas->CustomRects.empty());
+  int cell = cellSize(size);
+  for (int i = 0; i < Cells; i++) atlas->AddCustomRectRegular(cell, cell);
+}
+
+void GlyphLoader::reset(ImFontAtlas *atlas, float size, Source source) {
+  this->atlas = atlas;
+  this->source = std::move(source);
+  cell = cellSize(size);
+  used = 0;
+  count = -1;  // the atlas isn't built yet
+  if (size != this->size) {
+    close();
+    failed = false;
+  }
+  this->size = size;
+}
+
+int GlyphLoader::reserved() const {
+  if (atlas->CustomRects.Size < Cells) return 0;
+  for (int i = 0; i < Cells; i++) {
+    auto &rect = atlas->CustomRects[i];
+    if (!rect.IsPacked() || rect.Width != cell || rect.Height != cell || rect.GlyphID != 0) return 0;
+  }
+  return Cells;
+}
+
+bool GlyphLoader::open() {
+  if (face != nullptr) return true;
+  if (failed || !source) return false;
+  failed = true;
+
+  auto fail = [&]() {
+    close();
+    return false;
+  };
+
+  data = source();
+  if (data.empty() || FT_Init_FreeType(&library) != 0) return fail();
+  if (FT_New_Memory_Face(library, data.data(), (FT_Long)data.size(), 0, &face) != 0) return fail();
+  if (FT_Select_Charmap(face, FT_ENCODING_UNICODE) != 0) return fail();
+
+  // the line box is the pixel size, as imgui_freetype requests it
+  FT_Size_RequestRec req{FT_SIZE_REQUEST_TYPE_REAL_DIM, 0, (FT_Long)(size * 64), 0, 0};
+  if (FT_Request_Size(face, &req) != 0) return fail();
+  failed = false;
+  return true;
+}
+
+void GlyphLoader::close() {
+  if (face != nullptr) FT_Done_Face(face);
+  if (library != nullptr) FT_Done_FreeType(library);
+  face = nullptr;
+  library = nullptr;
+  data.clear();
+}
+
+bool GlyphLoader::add(const std::vector<ImWchar> &chars) {
+  if (atlas == nullptr || atlas->Fonts.empty() || atlas->TexID == nullptr) return true;
+  if (count < 0) count = reserved();
+  if (count == 0) return false;
+  if (!open()) return true;
+
+  ImFont *font = atlas->Fonts[0];
+  // BuildLookupTable() appends a tab glyph unless it's already the last one
+  if (!font->Glyphs.empty() && font->Glyphs.back().Codepoint == '\t') font->Glyphs.pop_back();
+
+  bool ok = true;
+  std::vector<uint32_t> pixels;
+  glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)atlas->TexID);
+  for (ImWchar c : chars) {
+    if (font->FindGlyphNoFallback(c) != nullptr) continue;
+    FT_UInt index = FT_Get_Char_Index(face, c);
+    if (index == 0 || FT_Load_Glyph(face, index, FT_LOAD_NO_BITMAP | FT_LOAD_TARGET_NORMAL) != 0) continue;
+    if (FT_Render_Glyph(face->glyph, FT_RENDER_MODE_NORMAL) != 0) continue;
+    const FT_Bitmap &bitmap = face->glyph->bitmap;
+    if (bitmap.pixel_mode != FT_PIXEL_MODE_GRAY) continue;
+
+    int w = std::min((int)bitmap.width, cell), h = std::min((int)bitmap.rows, cell);
+    float x0 = (float)face->glyph->bitmap_left;
+    float y0 = (float)-face->glyph->bitmap_top + IM_ROUND(font->Ascent);
+    float advance = (float)((face->glyph->advance.x + 63) / 64);
+    if (w == 0 || h == 0) {
+      font->AddGlyph(nullptr, c, x0, y0, x0, y0, 0, 0, 0, 0, advance);
+      continue;
+    }
+    if (used == count) {
+      ok = false;
+      break;
+    }
+
+    auto &rect = atlas->CustomRects[used++];
+    pixels.resize((size_t)w * h);
+    for (int y = 0; y < h; y++) {
+      const uint8_t *src = bitmap.buffer + (ptrdiff_t)y * bitmap.pitch;
+      size_t offset = (size_t)(rect.Y + y) * atlas->TexWidth + rect.X;
+      for (int x = 0; x < w; x++) {
+        pixels[(size_t)y * w + x] = IM_COL32(255, 255, 255, src[x]);
+        if (atlas->TexPixelsAlpha8 != nullptr) atlas->TexPixelsAlpha8[offset + x] = src[x];
+        if (atlas->TexPixelsRGBA32 != nullptr) atlas->TexPixelsRGBA32[offset + x] = pixels[(size_t)y * w + x];
+      }
+    }
+    glTexSubImage2D(GL_TEXTURE_2D, 0, rect.X, rect.Y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+    float u0 = rect.X * atlas->TexUvScale.x, v0 = rect.Y * atlas->TexUvScale.y;
+    font->AddGlyph(nullptr, c, x0, y0, x0 + w, y0 + h, u0, v0, (rect.X + w) * atlas->TexUvScale.x,
+                   (rect.Y + h) * atlas->TexUvScale.y, advance);
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  font->BuildLookupTable();
+  return ok;
+}
+}  // namespace ImPlay
@@ -0,0 +1,225 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+#include "helpers/ipc.h"
+
+namespace ImPlay {
+constexpr size_t MaxRequest = 64 * 1024 * 1024;
+constexpr int IdleTimeoutMs = 5000;
+
+IpcServer::IpcServer(std::string path, Handler handler) : path(std::move(path)), handler(std::move(handler)) {}
+
+// splits complete lines off buf, returns the replies for them
+static std::string handleLines(std::string &buf, const IpcServer::Handler &handler) {
+  std::string replies;
+  size_t start = 0, end;
+  while ((end = buf.find('\n', start)) != std::string::npos) {
+    std::string line = buf.substr(start, end - start);
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (!line.empty()) replies += handler(line) + "\n";
+    start = end + 1;
+  }
+  buf.erase(0, start);
+  return replies;
+}
+
+#ifdef _WIN32
+static HANDLE createPipe(const std::string &path, bool first) {
+  DWORD mode = PIPE_ACCESS_DUPLEX | (first ? FILE_FLAG_FIRST_PIPE_INSTANCE : 0);
+  return CreateNamedPipeA(path.c_str(), mode, PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT, PIPE_UNLIMITED_INSTANCES,
+                          64 * 1024, 64 * 1024, 0, nullptr);
+}
+
+IpcServer::~IpcServer() {
+  if (!thread.joinable()) return;
+  quit = true;
+  // unblock ConnectNamedPipe
+  HANDLE h = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+  if (h != INVALID_HANDLE_VALUE) CloseHandle(h);
+  thread.join();
+}
+
+bool IpcServer::start() {
+  // fails if another instance already owns the pipe
+  HANDLE h = createPipe(path, true);
+  if (h == INVALID_HANDLE_VALUE) return false;
+  pipe = h;
+  thread = std::thread(&IpcServer::serve, this);
+  return true;
+}
+
+void IpcServer::serve() {
+  HANDLE h = (HANDLE)pipe;
+  while (!quit && h != INVALID_HANDLE_VALUE) {
+    if (ConnectNamedPipe(h, nullptr) || GetLastError() == ERROR_PIPE_CONNECTED) {
+      std::string buf;
+      char chunk[4096];
+      DWORD n;
+      while (!quit && buf.size() < MaxRequest && ReadFile(h, chunk, sizeof(chunk), &n, nullptr) && n > 0) {
+        buf.append(chunk, n);
+        auto replies = handleLines(buf, handler);
+        DWORD written;
+        if (!replies.empty() && !WriteFile(h, replies.data(), (DWORD)replies.size(), &written, nullptr)) break;
+      }
+      FlushFileBuffers(h);
+      DisconnectNamedPipe(h);
+    }
+    CloseHandle(h);
+    h = quit ? INVALID_HANDLE_VALUE : createPipe(path, false);
+  }
+}
+
+std::optional<std::string> ipcRequest(const std::string &path, const std::string &request, int timeoutMs) {
+  HANDLE h = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+  if (h == INVALID_HANDLE_VALUE && GetLastError() == ERROR_PIPE_BUSY && WaitNamedPipeA(path.c_str(), timeoutMs))
+    h = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+  if (h == INVALID_HANDLE_VALUE) return std::nullopt;
+
+  std::string payload = request + "\n", reply;
+  DWORD n;
+  if (WriteFile(h, payload.data(), (DWORD)payload.size(), &n, nullptr)) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    char chunk[4096];
+    while (reply.find('\n') == std::string::npos && std::chrono::steady_clock::now() < deadline) {
+      DWORD avail = 0;
+      if (!PeekNamedPipe(h, nullptr, 0, nullptr, &avail, nullptr)) break;
+      if (avail == 0) {
+        Sleep(1);
+        continue;
+      }
+      if (!ReadFile(h, chunk, std::min<DWORD>(avail, sizeof(chunk)), &n, nullptr)) break;
+      reply.append(chunk, n);
+    }
+  }
+  CloseHandle(h);
+  return reply.substr(0, reply.find('\n'));
+}
+#else
+#ifdef MSG_NOSIGNAL
+constexpr int SendFlags = MSG_NOSIGNAL;
+#else
+constexpr int SendFlags = 0;
+#endif
+
+static bool sendAll(int fd, const std::string &data) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    ssize_t n = send(fd, data.data() + sent, data.size() - sent, SendFlags);
+    if (n <= 0) return false;
+    sent += n;
+  }
+  return true;
+}
+
+static int connectTo(const std::string &path) {
+  sockaddr_un addr{};
+  if (path.size() >= sizeof(addr.sun_path)) return -1;
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd == -1) return -1;
+#ifdef SO_NOSIGPIPE
+  int on = 1;
+  setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+  if (connect(fd, (sockaddr *)&addr, sizeof(addr)) == -1) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+IpcServer::~IpcServer() {
+  if (thread.joinable()) {
+    quit = true;
+    char c = 0;
+    [[maybe_unused]] auto n = write(wakeFds[1], &c, 1);
+    thread.join();
+  }
+  for (int fd : {listenFd, wakeFds[0], wakeFds[1]})
+    if (fd != -1) close(fd);
+  if (listenFd != -1) unlink(path.c_str());
+}
+
+bool IpcServer::start() {
+  // a socket that still accepts belongs to a running instance, otherwise it's stale
+  if (int fd = connectTo(path); fd != -1) {
+    close(fd);
+    return false;
+  }
+  sockaddr_un addr{};
+  if (path.size() >= sizeof(addr.sun_path)) return false;
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+  unlink(path.c_str());
+
+  listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listenFd == -1) return false;
+  if (bind(listenFd, (sockaddr *)&addr, sizeof(addr)) == -1 || listen(listenFd, 8) == -1 || pipe(wakeFds) == -1) {
+    close(listenFd);
+    listenFd = -1;
+    return false;
+  }
+  thread = std::thread(&IpcServer::serve, this);
+  return true;
+}
+
+void IpcServer::serve() {
+  while (!quit) {
+    pollfd fds[] = {{listenFd, POLLIN, 0}, {wakeFds[0], POLLIN, 0}};
+    if (poll(fds, 2, -1) <= 0 || fds[1].revents) continue;
+    int client = accept(listenFd, nullptr, nullptr);
+    if (client == -1) continue;
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+    std::string buf;
+    char chunk[4096];
+    while (!quit && buf.size() < MaxRequest) {
+      pollfd cfds[] = {{client, POLLIN, 0}, {wakeFds[0], POLLIN, 0}};
+      if (poll(cfds, 2, IdleTimeoutMs) <= 0 || cfds[1].revents) break;
+      ssize_t n = read(client, chunk, sizeof(chunk));
+      if (n <= 0) break;
+      buf.append(chunk, n);
+      if (!sendAll(client, handleLines(buf, handler))) break;
+    }
+    close(client);
+  }
+}
+
+std::optional<std::string> ipcRequest(const std::string &path, const std::string &request, int timeoutMs) {
+  int fd = connectTo(path);
+  if (fd == -1) return std::nullopt;
+
+  std::string reply;
+  if (sendAll(fd, request + "\n")) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    char chunk[4096];
+    while (reply.find('\n') == std::string::npos) {
+      auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+      pollfd pfd = {fd, POLLIN, 0};
+      if (left.count() <= 0 || poll(&pfd, 1, (int)left.count()) <= 0) break;
+      ssize_t n = read(fd, chunk, sizeof(chunk));
+      if (n <= 0) break;
+      reply.append(chunk, n);
+    }
+  }
+  close(fd);
+  return reply.substr(0, reply.find('\n'));
+}
+#endif
+}  // namespace ImPlay
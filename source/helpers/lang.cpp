@@ -2,10 +2,11 @@
 // SPDX-License-Identifier: GPL-2.0-only
 
 #include <fstream>
+#include <iterator>
 #include <romfs/romfs.hpp>
-#include <nlohmann/json.hpp>
 #include "helpers/utils.h"
 #include "helpers/lang.h"
+#include "helpers/lang_pack.h"
 
 namespace ImPlay {
 std::string LangData::get(std::string& key) {
@@ -14,84 +15,111 @@ std::string LangData::get(std::string& key) {
   return key;
 }
 
-LangStr::LangStr(std::string key) { m_str = i18n(key); }
+namespace {
+// where the pack of a language lives: bundled in romfs, or a user file converted into the cache
+struct LangSource {
+  std::string_view data;
+  std::filesystem::path file;
+  bool loaded = false;
+};
 
-LangStr::operator std::string() const { return m_str; }
+std::map<std::string, LangSource>& getLangSources() {
+  static std::map<std::string, LangSource> sources;
+  return sources;
+}
 
-LangStr::operator std::string_view() const { return m_str; }
+std::string readFile(const std::filesystem::path& path) {
+  std::ifstream f(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(f), {});
+}
 
-LangStr::operator const char*() const { return m_str.c_str(); }
+// user JSON files are parsed once and kept as packs, keyed by their path, size and mtime
+std::filesystem::path cacheUserLang(const std::filesystem::path& path, const std::filesystem::path& cacheDir) {
+  std::error_code ec;
+  auto size = std::filesystem::file_size(path, ec);
+  auto mtime = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+  auto key = langId(fmt::format("{}|{}|{}", path.string(), size, mtime));
+  auto cached = cacheDir / fmt::format("{}-{:016x}.bin", path.stem().string(), key);
+  if (std::filesystem::exists(cached, ec)) return cached;
 
-const ImWchar* getLangGlyphRanges() {
-  static ImVector<ImWchar> glyphRanges;
-  if (glyphRanges.empty()) {
-    ImFontGlyphRangesBuilder builder;
-    for (auto& [code, lang] : getLangs()) {
-      builder.AddText(lang.title.c_str());
-      for (auto& [key, value] : lang.entries) builder.AddText(value.c_str());
-    }
-    builder.BuildRanges(&glyphRanges);
-  }
-  return &glyphRanges[0];
+  LangData lang;
+  if (!LangPack::parseJson(readFile(path), lang)) return {};
+  std::filesystem::create_directories(cacheDir, ec);
+  std::ofstream out(cached, std::ios::binary);
+  out << LangPack::write(lang);
+  return out ? cached : std::filesystem::path();
 }
 
-static std::pair<LangData, bool> parseLang(nlohmann::json& j) {
-  LangData lang;
-  const auto& code = j["code"];
-  const auto& title = j["title"];
-  const auto& fonts = j["fonts"];
-  const auto& entries = j["entries"];
-  if (!code.is_string() && !title.is_string() && !entries.is_object()) return {lang, false};
-  if (j.contains("fallback")) {
-    const auto& fallback = j["fallback"];
-    if (fallback.is_boolean() && fallback.get<bool>()) getLangFallback() = code.get<std::string>();
-  }
-  lang.code = code.get<std::string>();
-  lang.title = title.get<std::string>();
-  if (fonts.is_array()) {
-    for (auto& [key, value] : fonts.items()) {
-      auto& path = value["path"];
-      if (!path.is_string()) continue;
-      LangFont font{path.get<std::string>()};
-      auto& size = value["size"];
-      auto& glyph_range = value["glyph-range"];
-      if (size.is_number_integer()) font.size = size.get<int>();
-      if (glyph_range.is_number_integer()) font.glyph_range = glyph_range.get<int>();
-      lang.fonts.emplace_back(font);
-    }
-  }
-  for (auto& [key, value] : entries.items()) {
-    if (key == "" || !value.is_string()) continue;
-    lang.entries[key] = value.get<std::string>();
+// decodes the entries of a language on first use
+LangData* loadLang(const std::string& code) {
+  auto& langs = getLangs();
+  auto it = langs.find(code);
+  if (it == langs.end()) return nullptr;
+  auto& source = getLangSources()[code];
+  if (!source.loaded) {
+    source.loaded = true;
+    if (!source.file.empty())
+      LangPack::read(readFile(source.file), it->second, true);
+    else
+      LangPack::read(source.data, it->second, true);
   }
-  return {lang, true};
+  return &it->second;
 }
+}  // namespace
 
 std::map<std::string, LangData>& getLangs() {
   static std::map<std::string, LangData> langs;
   static bool loaded = false;
   if (loaded) return langs;
 
+  auto add = [&](LangData& lang, LangSource source) {
+    if (langs.contains(lang.code)) return;
+    if (lang.fallback) getLangFallback() = lang.code;
+    getLangSources()[lang.code] = source;
+    langs.insert({lang.code, lang});
+  };
+
   auto langDir = dataPath() / "lang";
   if (std::filesystem::exists(langDir)) {
     for (auto& entry : std::filesystem::directory_iterator(langDir)) {
       if (entry.is_directory() || entry.path().extension() != ".json") continue;
-      std::ifstream f(entry.path());
-      auto j = nlohmann::json::parse(f);
-      if (auto [lang, ok] = parseLang(j); ok) langs.insert({lang.code, lang});
+      auto file = cacheUserLang(entry.path(), langDir / ".cache");
+      LangData lang;
+      if (!file.empty() && LangPack::read(readFile(file), lang, false)) add(lang, {{}, file});
     }
   }
 
   for (auto& path : romfs::list("lang")) {
-    auto file = romfs::get(path);
-    auto j = nlohmann::json::parse(file.data(), file.data() + file.size());
-    if (auto [lang, ok] = parseLang(j); ok) langs.insert({lang.code, lang});
+    auto& res = romfs::get(path);
+    std::string_view data(res.data<char>(), res.size());
+    LangData lang;
+    if (LangPack::read(data, lang, false)) add(lang, {data, {}});
   }
 
   loaded = true;
   return langs;
 }
 
+// glyphs of the current and fallback language, plus every language title for the language picker
+const ImWchar* getLangGlyphRanges() {
+  static ImVector<ImWchar> glyphRanges;
+  static std::string lastLang;
+  if (glyphRanges.empty() || lastLang != getLang()) {
+    ImFontGlyphRangesBuilder builder;
+    auto& langs = getLangs();
+    for (auto& [code, lang] : langs) builder.AddText(lang.title.c_str());
+    for (auto& code : {getLangFallback(), getLang()}) {
+      auto lang = loadLang(code);
+      if (lang == nullptr) continue;
+      for (auto& [key, value] : lang->entries) builder.AddText(value.c_str());
+    }
+    glyphRanges.clear();
+    builder.BuildRanges(&glyphRanges);
+    lastLang = getLang();
+  }
+  return &glyphRanges[0];
+}
+
 std::string& getLangFallback() {
   static std::string fallback = "en-US";
   return fallback;
@@ -102,28 +130,41 @@ std::string& getLang() {
   return lang;
 }
 
-std::string i18n(std::string key) {
+// open addressing table from key id to translation, rebuilt when the language changes
+std::string_view translate(uint64_t id, std::string_view key) {
+  struct Slot {
+    uint64_t id;
+    std::string_view value;
+  };
+  static std::vector<Slot> slots;
+  static size_t mask = 0;
   static std::string lang;
-  static std::map<std::string, std::string> entries;
-  if (entries.empty() || lang != getLang()) {
-    entries.clear();
-    auto langs = getLangs();
-    auto it = langs.find(getLang());
-    if (it != langs.end()) {
-      for (auto& [key, value] : it->second.entries) {
-        if (value != "") entries.insert({key, value});
-      }
+  if (slots.empty() || lang != getLang()) {
+    std::vector<const LangData*> sources;
+    size_t count = 0;
+    for (auto& code : {getLang(), getLangFallback()}) {
+      auto lang = loadLang(code);
+      if (lang == nullptr) continue;
+      sources.push_back(lang);
+      count += lang->entries.size();
     }
-    it = langs.find(getLangFallback());
-    if (it != langs.end()) {
-      for (auto& [key, value] : it->second.entries) {
-        if (value != "") entries.insert({key, value});
+    size_t size = 16;
+    while (size < count * 2) size <<= 1;
+    slots.assign(size, Slot{0, {}});
+    mask = size - 1;
+    for (auto source : sources) {
+      for (auto& [k, value] : source->entries) {
+        if (value.empty()) continue;
+        uint64_t h = langId(k);
+        size_t i = h & mask;
+        while (slots[i].id != 0 && slots[i].id != h) i = (i + 1) & mask;
+        if (slots[i].id == 0) slots[i] = {h, value};
       }
     }
     lang = getLang();
   }
-  auto it = entries.find(key);
-  if (it != entries.end()) return it->second;
+  for (size_t i = id & mask; slots[i].id != 0; i = (i + 1) & mask)
+    if (slots[i].id == id) return slots[i].value;
   return key;
 }
 }  // namespace ImPlay
\ No newline at end of file
@@ -0,0 +1,127 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <cstdint>
+#include <cstring>
+#include <nlohmann/json.hpp>
+#include "helpers/lang_pack.h"
+
+namespace ImPlay::LangPack {
+constexpr char Magic[4] = {'I', 'P', 'L', 'P'};
+constexpr uint32_t Version = 1;
+
+bool parseJson(std::string_view json, LangData& lang) {
+  auto j = nlohmann::json::parse(json, nullptr, false);
+  if (j.is_discarded() || !j.is_object()) return false;
+  const auto& code = j["code"];
+  const auto& title = j["title"];
+  const auto& fonts = j["fonts"];
+  const auto& entries = j["entries"];
+  if (!code.is_string() || !title.is_string() || !entries.is_object()) return false;
+  if (j.contains("fallback")) {
+    const auto& fallback = j["fallback"];
+    lang.fallback = fallback.is_boolean() && fallback.get<bool>();
+  }
+  lang.code = code.get<std::string>();
+  lang.title = title.get<std::string>();
+  if (fonts.is_array()) {
+    for (auto& [key, value] : fonts.items()) {
+      auto& path = value["path"];
+      if (!path.is_string()) continue;
+      LangFont font{path.get<std::string>()};
+      auto& size = value["size"];
+      auto& glyph_range = value["glyph-range"];
+      if (size.is_number_integer()) font.size = size.get<int>();
+      if (glyph_range.is_number_integer()) font.glyph_range = glyph_range.get<int>();
+      lang.fonts.emplace_back(font);
+    }
+  }
+  for (auto& [key, value] : entries.items()) {
+    if (key == "" || !value.is_string()) continue;
+    lang.entries[key] = value.get<std::string>();
+  }
+  return true;
+}
+
+// integers are stored little endian, strings as a length followed by the bytes
+static void putU32(std::string& out, uint32_t v) {
+  for (int i = 0; i < 4; i++) out.push_back((char)((v >> (i * 8)) & 0xff));
+}
+
+static void putStr(std::string& out, std::string_view s) {
+  putU32(out, (uint32_t)s.size());
+  out.append(s);
+}
+
+std::string write(const LangData& lang) {
+  std::string out(Magic, sizeof(Magic));
+  putU32(out, Version);
+  putStr(out, lang.code);
+  putStr(out, lang.title);
+  out.push_back(lang.fallback ? 1 : 0);
+  putU32(out, (uint32_t)lang.fonts.size());
+  for (auto& font : lang.fonts) {
+    putStr(out, font.path);
+    putU32(out, (uint32_t)font.size);
+    putU32(out, (uint32_t)font.glyph_range);
+  }
+  putU32(out, (uint32_t)lang.entries.size());
+  for (auto& [key, value] : lang.entries) {
+    putStr(out, key);
+    putStr(out, value);
+  }
+  return out;
+}
+
+namespace {
+struct Reader {
+  std::string_view data;
+
+  bool u32(uint32_t& v) {
+    if (data.size() < 4) return false;
+    v = 0;
+    for (int i = 0; i < 4; i++) v |= (uint32_t)(unsigned char)data[i] << (i * 8);
+    data.remove_prefix(4);
+    return true;
+  }
+  bool str(std::string& s) {
+    uint32_t n;
+    if (!u32(n) || data.size() < n) return false;
+    s.assign(data.data(), n);
+    data.remove_prefix(n);
+    return true;
+  }
+};
+}  // namespace
+
+bool read(std::string_view data, LangData& lang, bool withEntries) {
+  if (data.size() < sizeof(Magic) || memcmp(data.data(), Magic, sizeof(Magic)) != 0) return false;
+  Reader r{data.substr(sizeof(Magic))};
+  uint32_t version, count;
+  if (!r.u32(version) || version != Version) return false;
+  if (!r.str(lang.code) || !r.str(lang.title) || r.data.empty()) return false;
+  lang.fallback = r.data[0] != 0;
+  r.data.remove_prefix(1);
+
+  if (!r.u32(count)) return false;
+  lang.fonts.clear();
+  for (uint32_t i = 0; i < count; i++) {
+    LangFont font;
+    uint32_t size, range;
+    if (!r.str(font.path) || !r.u32(size) || !r.u32(range)) return false;
+    font.size = (int)size;
+    font.glyph_range = (int)range;
+    lang.fonts.push_back(font);
+  }
+  if (!withEntries) return true;
+
+  if (!r.u32(count)) return false;
+  lang.entries.clear();
+  std::string key, value;
+  for (uint32_t i = 0; i < count; i++) {
+    if (!r.str(key) || !r.str(value)) return false;
+    lang.entries.emplace_hint(lang.entries.end(), key, value);
+  }
+  return true;
+}
+}  // namespace ImPlay::LangPack
@@ -0,0 +1,73 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "helpers/log_file.h"
+
+namespace ImPlay {
+LogFile::LogFile(std::filesystem::path path, size_t maxSize, int maxFiles)
+    : path(path), maxSize(maxSize), maxFiles(maxFiles) {
+  std::error_code ec;
+  written = std::filesystem::exists(path, ec) ? std::filesystem::file_size(path, ec) : 0;
+  if (ec) written = 0;
+  file.open(path, std::ios::binary | std::ios::app);
+  worker = std::thread(&LogFile::writeLoop, this);
+}
+
+LogFile::~LogFile() {
+  {
+    std::lock_guard<std::mutex> l(lock);
+    quit = true;
+  }
+  cond.notify_one();
+  worker.join();
+}
+
+void LogFile::write(std::string line) {
+  bool wake;
+  {
+    std::lock_guard<std::mutex> l(lock);
+    if (pending.size() >= MaxPending) {
+      droppedLines++;
+      return;
+    }
+    wake = pending.empty();
+    pending.push_back(std::move(line));
+  }
+  if (wake) cond.notify_one();
+}
+
+void LogFile::writeLoop() {
+  std::vector<std::string> lines;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> l(lock);
+      cond.wait(l, [this] { return quit || !pending.empty(); });
+      if (pending.empty() && quit) break;
+      lines.swap(pending);
+    }
+
+    for (auto &line : lines) {
+      file.write(line.data(), line.size());
+      written += line.size();
+      if (maxSize > 0 && written >= maxSize) rotate();
+    }
+    file.flush();
+    lines.clear();
+  }
+}
+
+void LogFile::rotate() {
+  file.close();
+  auto rotated = [this](int n) {
+    auto p = path;
+    p += "." + std::to_string(n);
+    return p;
+  };
+  std::error_code ec;
+  std::filesystem::remove(rotated(maxFiles), ec);
+  for (int i = maxFiles - 1; i > 0; i--) std::filesystem::rename(rotated(i), rotated(i + 1), ec);
+  std::filesystem::rename(path, rotated(1), ec);
+  file.open(path, std::ios::binary | std::ios::trunc);
+  written = 0;
+}
+}  // namespace ImPlay
@@ -0,0 +1,284 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include "helpers/log_index.h"
+
+namespace ImPlay {
+constexpr size_t BatchLines = 64 * 1024;
+
+static inline char lower(char c) { return (c >= 'A' && c <= 'Z') ? (char)(c | 0x20) : c; }
+
+struct CharHash {
+  bool fold;
+  size_t operator()(char c) const { return std::hash<char>{}(fold ? lower(c) : c); }
+};
+struct CharEqual {
+  bool fold;
+  bool operator()(char a, char b) const { return fold ? lower(a) == lower(b) : a == b; }
+};
+
+struct LogIndex::Matcher {
+  using Searcher = std::boyer_moore_horspool_searcher<std::string::const_iterator, CharHash, CharEqual>;
+
+  explicit Matcher(const Query &q) : query(q) {
+    if (query.pattern.empty()) return;
+    if (query.regex) {
+      auto flags = std::regex::ECMAScript | std::regex::optimize;
+      if (!query.matchCase) flags |= std::regex::icase;
+      regex.emplace(query.pattern, flags);
+    } else {
+      bool fold = !query.matchCase;
+      literal.emplace(query.pattern.cbegin(), query.pattern.cend(), CharHash{fold}, CharEqual{fold});
+    }
+  }
+
+  bool match(const Line &line) const {
+    if (query.maxLevel >= 0 && (line.level < 0 || line.level > query.maxLevel)) return false;
+    if (!query.prefix.empty() && line.prefix.find(query.prefix) == std::string_view::npos) return false;
+    auto begin = line.text.data(), end = begin + std::min(line.text.size(), MaxLineLength);
+    if (regex) return std::regex_search(begin, end, *regex);
+    if (literal) return (*literal)(begin, end).first != end;
+    return true;
+  }
+
+  const Query query;
+  std::optional<std::regex> regex;
+  std::optional<Searcher> literal;
+};
+
+LogIndex::~LogIndex() { close(); }
+
+void LogIndex::open(const std::filesystem::path &path) {
+  auto mapped = std::make_shared<const MappedFile>(path);
+  close();
+  {
+    std::lock_guard<std::mutex> l(lock);
+    m_path = path;
+    file = mapped;
+    ends.reserve(mapped->size() / 100);
+  }
+  startIndex(0);
+  if (!query.empty()) startSearch(0);
+}
+
+void LogIndex::close() {
+  stopIndex();
+  stopSearch();
+  std::lock_guard<std::mutex> l(lock);
+  file.reset();
+  ends = {};
+  matches.clear();
+  searched = 0;
+}
+
+bool LogIndex::refresh() {
+  if (!file) return false;
+  std::error_code ec;
+  auto size = std::filesystem::file_size(m_path, ec);
+  if (ec || size == file->size()) return false;
+
+  std::shared_ptr<const MappedFile> mapped;
+  try {
+    // a smaller file was truncated or rotated, start over
+    if (size < file->size()) {
+      open(m_path);
+      return true;
+    }
+    mapped = std::make_shared<const MappedFile>(m_path);
+  } catch (const std::exception &) {
+    return false;
+  }
+
+  stopIndex();
+  stopSearch();
+  size_t from;
+  {
+    std::lock_guard<std::mutex> l(lock);
+    file = mapped;
+    // the last line may have been cut short by the writer, index it again
+    if (!ends.empty() && ends.back() <= mapped->size() && mapped->data()[ends.back() - 1] != '\n') ends.pop_back();
+    from = ends.empty() ? 0 : ends.back();
+    if (searched > ends.size()) {
+      searched = ends.size();
+      matches.erase(std::lower_bound(matches.begin(), matches.end(), searched), matches.end());
+    }
+  }
+  startIndex(from);
+  if (!query.empty()) startSearch(searched);
+  return true;
+}
+
+size_t LogIndex::lineCount() {
+  std::lock_guard<std::mutex> l(lock);
+  return ends.size();
+}
+
+LogIndex::Line LogIndex::line(size_t n) {
+  uint64_t begin, end;
+  {
+    std::lock_guard<std::mutex> l(lock);
+    if (n >= ends.size()) return {};
+    begin = n > 0 ? ends[n - 1] : 0;
+    end = ends[n];
+  }
+  std::string_view text(file->data() + begin, end - begin);
+  while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) text.remove_suffix(1);
+  return parse(text);
+}
+
+LogIndex::Line LogIndex::parse(std::string_view text) {
+  Line line{text, {}, -1};
+  if (text.empty() || text[0] != '[') return line;
+  size_t i = text.find(']');
+  if (i == std::string_view::npos) return line;
+
+  auto field = [&](std::string_view &out) {
+    if (++i >= text.size() || text[i] != '[') return false;
+    size_t end = text.find(']', i);
+    if (end == std::string_view::npos) return false;
+    out = text.substr(i + 1, end - i - 1);
+    i = end;
+    return true;
+  };
+  std::string_view level;
+  if (!field(level)) return line;
+  for (int n = 0; n < (int)std::size(Levels); n++) {
+    if (level == Levels[n]) line.level = n;
+  }
+  field(line.prefix);
+  return line;
+}
+
+void LogIndex::search(const Query &q) {
+  auto m = std::make_shared<const Matcher>(q);
+  stopSearch();
+  {
+    std::lock_guard<std::mutex> l(lock);
+    matches.clear();
+    searched = 0;
+  }
+  query = q;
+  matcher = m;
+  if (!query.empty() && file) startSearch(0);
+}
+
+size_t LogIndex::matchCount() {
+  std::lock_guard<std::mutex> l(lock);
+  return matches.size();
+}
+
+size_t LogIndex::matchAt(size_t i) {
+  std::lock_guard<std::mutex> l(lock);
+  return i < matches.size() ? matches[i] : 0;
+}
+
+bool LogIndex::isMatch(size_t line) {
+  std::lock_guard<std::mutex> l(lock);
+  return std::binary_search(matches.begin(), matches.end(), line);
+}
+
+std::optional<size_t> LogIndex::nextMatch(size_t line, bool forward) {
+  std::lock_guard<std::mutex> l(lock);
+  if (forward) {
+    auto it = std::upper_bound(matches.begin(), matches.end(), line);
+    if (it != matches.end()) return *it;
+  } else {
+    auto it = std::lower_bound(matches.begin(), matches.end(), line);
+    if (it != matches.begin()) return *(it - 1);
+  }
+  return std::nullopt;
+}
+
+size_t LogIndex::matchIndex(size_t line) {
+  std::lock_guard<std::mutex> l(lock);
+  return std::lower_bound(matches.begin(), matches.end(), line) - matches.begin();
+}
+
+void LogIndex::startIndex(size_t from) {
+  m_indexing = true;
+  indexer = std::thread(&LogIndex::indexLoop, this, ++indexGen, file, from);
+}
+
+void LogIndex::stopIndex() {
+  indexGen++;
+  if (indexer.joinable()) indexer.join();
+  m_indexing = false;
+}
+
+void LogIndex::startSearch(size_t from) {
+  m_searching = true;
+  searcher = std::thread(&LogIndex::searchLoop, this, ++searchGen, matcher, from);
+}
+
+void LogIndex::stopSearch() {
+  searchGen++;
+  if (searcher.joinable()) searcher.join();
+  m_searching = false;
+}
+
+void LogIndex::indexLoop(uint64_t gen, std::shared_ptr<const MappedFile> mapped, size_t from) {
+  const char *data = mapped->data();
+  size_t size = mapped->size();
+  std::vector<uint64_t> batch;
+  batch.reserve(BatchLines);
+
+  auto flush = [&]() {
+    std::lock_guard<std::mutex> l(lock);
+    if (gen != indexGen) return false;
+    ends.insert(ends.end(), batch.begin(), batch.end());
+    batch.clear();
+    return true;
+  };
+
+  size_t pos = from;
+  while (pos < size) {
+    auto nl = static_cast<const char *>(memchr(data + pos, '\n', size - pos));
+    pos = nl != nullptr ? nl - data + 1 : size;
+    batch.push_back(pos);
+    if (batch.size() == BatchLines && !flush()) return;
+  }
+  if (flush()) m_indexing = false;
+}
+
+void LogIndex::searchLoop(uint64_t gen, std::shared_ptr<const Matcher> m, size_t from) {
+  std::vector<uint64_t> batch, found;
+  size_t pos = from;
+  while (gen == searchGen) {
+    std::shared_ptr<const MappedFile> mapped;
+    uint64_t begin = 0;
+    bool done;
+    {
+      std::lock_guard<std::mutex> l(lock);
+      done = !m_indexing;
+      size_t last = std::min(ends.size(), pos + BatchLines);
+      batch.assign(ends.begin() + std::min(pos, last), ends.begin() + last);
+      if (pos > 0 && pos <= ends.size()) begin = ends[pos - 1];
+      mapped = file;
+    }
+    if (batch.empty()) {
+      if (done) break;
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      continue;
+    }
+
+    found.clear();
+    for (size_t i = 0; i < batch.size(); i++) {
+      std::string_view text(mapped->data() + begin, batch[i] - begin);
+      while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) text.remove_suffix(1);
+      if (m->match(parse(text))) found.push_back(pos + i);
+      begin = batch[i];
+    }
+    pos += batch.size();
+
+    std::lock_guard<std::mutex> l(lock);
+    if (gen != searchGen) return;
+    matches.insert(matches.end(), found.begin(), found.end());
+    searched = pos;
+  }
+  if (gen == searchGen) m_searching = false;
+}
+}  // namespace ImPlay
@@ -0,0 +1,204 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <fmt/format.h>
+#include <mpv/client.h>
+#include "helpers/loudness.h"
+#include "helpers/utils.h"
+
+namespace ImPlay {
+constexpr char Magic[4] = {'I', 'P', 'L', 'U'};
+constexpr uint32_t Version = 1;
+constexpr size_t MaxFiles = 4096;
+
+namespace {
+struct Header {
+  char magic[4];
+  uint32_t version;
+  uint64_t key;
+};  // followed by the result
+}  // namespace
+
+LoudnessScanner::LoudnessScanner(const std::filesystem::path &dir, int workers) : dir(dir), workers(workers) {
+  // decoding is single threaded per worker, leave half the cores to playback
+  if (this->workers <= 0) this->workers = (int)std::clamp(std::thread::hardware_concurrency() / 2, 1u, 4u);
+}
+
+LoudnessScanner::~LoudnessScanner() {
+  {
+    std::lock_guard<std::mutex> l(lock);
+    quit = true;
+  }
+  cond.notify_all();
+  for (auto &thread : threads) thread.join();
+}
+
+void LoudnessScanner::request(const std::vector<std::string> &paths) {
+  std::lock_guard<std::mutex> l(lock);
+  queue.clear();
+  for (auto &path : paths)
+    if (!busy.count(path) && !failed.count(path) && !results.count(path)) queue.push_back(path);
+  if (queue.empty()) return;
+  while ((int)threads.size() < workers) threads.emplace_back(&LoudnessScanner::run, this);
+  cond.notify_all();
+}
+
+std::optional<LoudnessScanner::Result> LoudnessScanner::lookup(const std::string &path) {
+  {
+    std::lock_guard<std::mutex> l(lock);
+    if (auto it = results.find(path); it != results.end()) return it->second;
+  }
+  // scanned in an earlier session
+  uint64_t key = fileKey(path);
+  Result result;
+  if (!load(cacheFile(key), key, result)) return std::nullopt;
+  std::lock_guard<std::mutex> l(lock);
+  results[path] = result;
+  return result;
+}
+
+void LoudnessScanner::run() {
+  lowerThreadPriority();
+  std::unique_lock<std::mutex> l(lock);
+  while (true) {
+    cond.wait(l, [this]() { return quit || !queue.empty(); });
+    if (quit) break;
+    auto path = queue.front();
+    queue.pop_front();
+    busy.insert(path);
+    l.unlock();
+
+    uint64_t key = fileKey(path);
+    auto file = cacheFile(key);
+    Result result;
+    bool ok = load(file, key, result);
+    if (!ok && (ok = measure(path, key, result))) store(file, key, result);
+
+    l.lock();
+    busy.erase(path);
+    if (ok)
+      results[path] = result;
+    else if (!quit)
+      failed.insert(path);
+    if (ok && !quit && resultCb) {
+      l.unlock();
+      resultCb(path);
+      l.lock();
+    }
+  }
+}
+
+std::filesystem::path LoudnessScanner::cacheFile(uint64_t key) const {
+  return dir / fmt::format("{:016x}.r128", key);
+}
+
+// ebur128 tags each frame with the values so far, the last frame has them for the whole file; libav logs
+// only reach the player's mpv, so ametadata prints them to a scratch file. Frames of 64k samples keep it small.
+bool LoudnessScanner::measure(const std::string &path, uint64_t key, Result &result) {
+  std::error_code ec;
+  auto out = createScratchFile(dir, fmt::format("{:016x}", key), ".txt");
+  if (out.empty()) return false;
+  auto outPath = out.generic_u8string();
+  auto graph = fmt::format("asetnsamples=n=65536:p=0,ebur128=metadata=1:peak=sample,ametadata=print:file={}",
+                           escapeLavfi("file:" + std::string(outPath.begin(), outPath.end())));
+  auto af = fmt::format("lavfi=graph=%{}%{}", graph.size(), graph);
+
+  mpv_handle *ctx = mpv_create();
+  if (!ctx) {
+    std::filesystem::remove(out, ec);
+    return false;
+  }
+  mpv_set_option_string(ctx, "config", "no");
+  mpv_set_option_string(ctx, "terminal", "no");
+  mpv_set_option_string(ctx, "load-scripts", "no");
+  mpv_set_option_string(ctx, "ytdl", "no");
+  mpv_set_option_string(ctx, "vid", "no");
+  mpv_set_option_string(ctx, "sid", "no");
+  mpv_set_option_string(ctx, "vo", "null");
+  mpv_set_option_string(ctx, "audio-display", "no");
+  mpv_set_option_string(ctx, "ao", "null");
+  mpv_set_option_string(ctx, "ao-null-untimed", "yes");
+  mpv_set_option_string(ctx, "untimed", "yes");
+  mpv_set_option_string(ctx, "demuxer-thread", "no");
+  mpv_set_option_string(ctx, "af", af.c_str());
+  // lowers the core thread where the OS doesn't let it inherit the worker's priority
+  mpv_set_wakeup_callback(ctx, [](void *) { lowerThreadPriority(); }, nullptr);
+  if (mpv_initialize(ctx) < 0) {
+    mpv_terminate_destroy(ctx);
+    std::filesystem::remove(out, ec);
+    return false;
+  }
+  const char *cmd[] = {"loadfile", path.c_str(), nullptr};
+  mpv_command(ctx, cmd);
+
+  bool done = false, ok = false;
+  while (!done && !quit) {
+    mpv_event *event = mpv_wait_event(ctx, 0.1);
+    switch (event->event_id) {
+      case MPV_EVENT_END_FILE:
+        ok = ((mpv_event_end_file *)event->data)->reason == MPV_END_FILE_REASON_EOF;
+        done = true;
+        break;
+      case MPV_EVENT_SHUTDOWN:
+        done = true;
+        break;
+      default:
+        break;
+    }
+  }
+  // closes the file
+  mpv_terminate_destroy(ctx);
+
+  double integrated = NAN, peak = NAN;
+  if (ok && !quit) {
+    std::ifstream in(out);
+    std::string line;
+    while (std::getline(in, line)) {
+      if (line.starts_with("lavfi.r128.I="))
+        integrated = strtod(line.c_str() + strlen("lavfi.r128.I="), nullptr);
+      else if (line.starts_with("lavfi.r128.sample_peak="))
+        peak = 20 * log10(strtod(line.c_str() + strlen("lavfi.r128.sample_peak="), nullptr));  // linear
+    }
+  }
+  std::filesystem::remove(out, ec);
+
+  // silence has no loudness to match
+  if (!ok || quit || !std::isfinite(integrated) || integrated <= -70 || !std::isfinite(peak)) return false;
+  result = {integrated, peak};
+  return true;
+}
+
+bool LoudnessScanner::load(const std::filesystem::path &file, uint64_t key, Result &result) const {
+  std::ifstream in(file, std::ios::binary);
+  Header h;
+  if (!in || !in.read((char *)&h, sizeof(h)) || !in.read((char *)&result, sizeof(result))) return false;
+  return memcmp(h.magic, Magic, sizeof(Magic)) == 0 && h.version == Version && h.key == key;
+}
+
+void LoudnessScanner::store(const std::filesystem::path &file, uint64_t key, const Result &result) const {
+  Header h{};
+  memcpy(h.magic, Magic, sizeof(Magic));
+  h.version = Version;
+  h.key = key;
+
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+  auto tmp = file;
+  tmp += ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out || !out.write((const char *)&h, sizeof(h)) || !out.write((const char *)&result, sizeof(result))) return;
+  }
+  std::filesystem::rename(tmp, file, ec);
+  if (ec) {
+    std::filesystem::remove(tmp, ec);
+    return;
+  }
+  prune(dir, ".r128", MaxFiles);
+}
+}  // namespace ImPlay
@@ -0,0 +1,71 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <stdexcept>
+#include <fmt/format.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "helpers/mapped_file.h"
+
+namespace ImPlay {
+#ifdef _WIN32
+MappedFile::MappedFile(const std::filesystem::path &path) {
+  HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) throw std::runtime_error(fmt::format("could not open {}", path.string()));
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+    CloseHandle(file);
+    throw std::runtime_error(fmt::format("could not stat {}", path.string()));
+  }
+  m_file = file;
+  m_size = (size_t)size.QuadPart;
+  if (m_size == 0) return;
+
+  m_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (m_mapping != nullptr) m_data = (const char *)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, m_size);
+  if (m_data == nullptr) {
+    if (m_mapping != nullptr) CloseHandle(m_mapping);
+    CloseHandle(file);
+    throw std::runtime_error(fmt::format("could not map {}", path.string()));
+  }
+}
+
+MappedFile::~MappedFile() {
+  if (m_data != nullptr) UnmapViewOfFile(m_data);
+  if (m_mapping != nullptr) CloseHandle(m_mapping);
+  if (m_file != nullptr) CloseHandle(m_file);
+}
+#else
+MappedFile::MappedFile(const std::filesystem::path &path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) throw std::runtime_error(fmt::format("could not open {}", path.string()));
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw std::runtime_error(fmt::format("could not stat {}", path.string()));
+  }
+  m_size = (size_t)st.st_size;
+  if (m_size > 0) {
+    void *p = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+      ::close(fd);
+      throw std::runtime_error(fmt::format("could not map {}", path.string()));
+    }
+    madvise(p, m_size, MADV_SEQUENTIAL);
+    m_data = (const char *)p;
+  }
+  ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (m_data != nullptr) munmap((void *)m_data, m_size);
+}
+#endif
+}  // namespace ImPlay
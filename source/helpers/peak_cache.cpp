@@ -0,0 +1,268 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PEAKS_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define PEAKS_NEON
+#endif
+#include <fmt/format.h>
+#include <mpv/client.h>
+#include "helpers/peak_cache.h"
+#include "helpers/utils.h"
+
+namespace ImPlay {
+constexpr char Magic[4] = {'I', 'P', 'W', 'F'};
+constexpr uint32_t Version = 1;
+constexpr size_t MaxFiles = 256;
+constexpr size_t MinPeaks = 256;  // the coarsest level
+
+namespace {
+struct Header {
+  char magic[4];
+  uint32_t version;
+  uint64_t key;
+  uint64_t levels;
+};  // followed by the peak count of each level, then the peaks, finest level first
+
+PeakCache::Peak blockPeak(const int16_t *s, size_t n) {
+  size_t i = 0;
+  int16_t lo = INT16_MAX, hi = INT16_MIN;
+#if defined(PEAKS_SSE2)
+  if (n >= 8) {
+    __m128i vmin = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s)), vmax = vmin;
+    for (i = 8; i + 8 <= n; i += 8) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+      vmin = _mm_min_epi16(vmin, v);
+      vmax = _mm_max_epi16(vmax, v);
+    }
+    // fold the 8 lanes down to one
+    vmin = _mm_min_epi16(vmin, _mm_shuffle_epi32(vmin, _MM_SHUFFLE(1, 0, 3, 2)));
+    vmax = _mm_max_epi16(vmax, _mm_shuffle_epi32(vmax, _MM_SHUFFLE(1, 0, 3, 2)));
+    vmin = _mm_min_epi16(vmin, _mm_shuffle_epi32(vmin, _MM_SHUFFLE(2, 3, 0, 1)));
+    vmax = _mm_max_epi16(vmax, _mm_shuffle_epi32(vmax, _MM_SHUFFLE(2, 3, 0, 1)));
+    vmin = _mm_min_epi16(vmin, _mm_shufflelo_epi16(vmin, _MM_SHUFFLE(2, 3, 0, 1)));
+    vmax = _mm_max_epi16(vmax, _mm_shufflelo_epi16(vmax, _MM_SHUFFLE(2, 3, 0, 1)));
+    lo = (int16_t)_mm_extract_epi16(vmin, 0);
+    hi = (int16_t)_mm_extract_epi16(vmax, 0);
+  }
+#elif defined(PEAKS_NEON)
+  if (n >= 8) {
+    int16x8_t vmin = vld1q_s16(s), vmax = vmin;
+    for (i = 8; i + 8 <= n; i += 8) {
+      int16x8_t v = vld1q_s16(s + i);
+      vmin = vminq_s16(vmin, v);
+      vmax = vmaxq_s16(vmax, v);
+    }
+    lo = vminvq_s16(vmin);
+    hi = vmaxvq_s16(vmax);
+  }
+#endif
+  for (; i < n; i++) {
+    lo = std::min(lo, s[i]);
+    hi = std::max(hi, s[i]);
+  }
+  return {lo, hi};
+}
+}  // namespace
+
+// a cancelled decode may still be running on this
+PeakCache::~PeakCache() {
+  close();
+  std::unique_lock<std::mutex> l(lock);
+  idle.wait(l, [this]() { return running == 0; });
+}
+
+void PeakCache::open(const std::string &path) {
+  close();
+  uint64_t key = fileKey(path);
+  auto file = dir / fmt::format("{:016x}.peaks", key);
+  if (load(file, key)) return;
+
+  std::lock_guard<std::mutex> l(lock);
+  cancel = std::make_shared<std::atomic<bool>>(false);
+  running++;
+  // detached, so a close never waits for the decode to stop
+  std::thread([this, path, file, key, stop = cancel]() {
+    scan(path, file, key, stop);
+    std::lock_guard<std::mutex> l(lock);
+    running--;
+    idle.notify_all();
+  }).detach();
+}
+
+void PeakCache::close() {
+  std::lock_guard<std::mutex> l(lock);
+  if (cancel) *cancel = true;
+  cancel.reset();
+  mapped.reset();
+  levels.clear();
+}
+
+bool PeakCache::load(const std::filesystem::path &file, uint64_t key, const std::atomic<bool> *stop) {
+  std::shared_ptr<const MappedFile> m;
+  try {
+    m = std::make_shared<const MappedFile>(file);
+  } catch (const std::exception &) {
+    return false;
+  }
+  Header h;
+  if (m->size() < sizeof(h)) return false;
+  memcpy(&h, m->data(), sizeof(h));
+  if (memcmp(h.magic, Magic, sizeof(Magic)) != 0 || h.version != Version || h.key != key) return false;
+  if (h.levels == 0 || h.levels > 64 || m->size() < sizeof(h) + h.levels * sizeof(uint64_t)) return false;
+
+  std::vector<std::pair<const Peak *, size_t>> lv;
+  auto counts = reinterpret_cast<const uint64_t *>(m->data() + sizeof(h));
+  size_t offset = sizeof(h) + h.levels * sizeof(uint64_t);
+  for (size_t i = 0; i < h.levels; i++) {
+    if (counts[i] > (m->size() - offset) / sizeof(Peak)) return false;
+    lv.emplace_back(reinterpret_cast<const Peak *>(m->data() + offset), counts[i]);
+    offset += counts[i] * sizeof(Peak);
+  }
+
+  std::lock_guard<std::mutex> l(lock);
+  if (stop != nullptr && *stop) return false;
+  levels = std::move(lv);
+  mapped = std::move(m);
+  return true;
+}
+
+// ao_pcm writes the downmixed audio to a private file next to the cache as fast as it decodes
+void PeakCache::scan(std::string path, std::filesystem::path file, uint64_t key,
+                     std::shared_ptr<std::atomic<bool>> stop) {
+  lowerThreadPriority();
+  std::error_code ec;
+  auto pcm = createScratchFile(dir, fmt::format("{:016x}", key), ".pcm");
+  if (pcm.empty()) return;
+  auto pcmPath = pcm.u8string();
+  auto rate = std::to_string(SampleRate);
+
+  mpv_handle *ctx = mpv_create();
+  if (!ctx) {
+    std::filesystem::remove(pcm, ec);
+    return;
+  }
+  mpv_set_option_string(ctx, "config", "no");
+  mpv_set_option_string(ctx, "terminal", "no");
+  mpv_set_option_string(ctx, "load-scripts", "no");
+  mpv_set_option_string(ctx, "ytdl", "no");
+  mpv_set_option_string(ctx, "vid", "no");
+  mpv_set_option_string(ctx, "sid", "no");
+  mpv_set_option_string(ctx, "vo", "null");
+  mpv_set_option_string(ctx, "audio-display", "no");
+  mpv_set_option_string(ctx, "ao", "pcm");
+  mpv_set_option_string(ctx, "ao-pcm-file", std::string(pcmPath.begin(), pcmPath.end()).c_str());
+  mpv_set_option_string(ctx, "ao-pcm-waveheader", "no");
+  mpv_set_option_string(ctx, "audio-format", "s16");
+  mpv_set_option_string(ctx, "audio-channels", "mono");
+  mpv_set_option_string(ctx, "audio-samplerate", rate.c_str());
+  mpv_set_option_string(ctx, "untimed", "yes");
+  mpv_set_option_string(ctx, "demuxer-thread", "no");
+  // the events come from the core thread, which does the decoding with the demuxer thread off
+  mpv_set_wakeup_callback(ctx, [](void *) { lowerThreadPriority(); }, nullptr);
+  if (mpv_initialize(ctx) < 0) {
+    mpv_terminate_destroy(ctx);
+    std::filesystem::remove(pcm, ec);
+    return;
+  }
+  const char *cmd[] = {"loadfile", path.c_str(), nullptr};
+  mpv_command(ctx, cmd);
+
+  bool done = false, ok = false;
+  while (!done && !*stop) {
+    mpv_event *event = mpv_wait_event(ctx, 0.1);
+    if (event->event_id == MPV_EVENT_END_FILE) {
+      ok = ((mpv_event_end_file *)event->data)->reason == MPV_END_FILE_REASON_EOF;
+      done = true;
+    } else if (event->event_id == MPV_EVENT_SHUTDOWN) {
+      done = true;
+    }
+  }
+  // closes the pcm file
+  mpv_terminate_destroy(ctx);
+
+  std::vector<std::vector<Peak>> lv(1);
+  if (ok && !*stop) {
+    std::ifstream in(pcm, std::ios::binary);
+    std::vector<int16_t> buf(BlockSize * 4096);
+    while (in && !*stop) {
+      in.read((char *)buf.data(), buf.size() * sizeof(int16_t));
+      size_t n = (size_t)in.gcount() / sizeof(int16_t);
+      for (size_t i = 0; i < n; i += BlockSize)
+        lv[0].push_back(blockPeak(buf.data() + i, std::min<size_t>(BlockSize, n - i)));
+    }
+  }
+  std::filesystem::remove(pcm, ec);
+  if (!ok || *stop || lv[0].empty()) return;
+
+  while (lv.back().size() > MinPeaks) {
+    auto &prev = lv.back();
+    std::vector<Peak> next((prev.size() + 1) / 2);
+    for (size_t i = 0; i < next.size(); i++) {
+      auto &a = prev[2 * i], &b = prev[std::min(2 * i + 1, prev.size() - 1)];
+      next[i] = {std::min(a.min, b.min), std::max(a.max, b.max)};
+    }
+    lv.push_back(std::move(next));
+  }
+
+  Header h{};
+  memcpy(h.magic, Magic, sizeof(Magic));
+  h.version = Version;
+  h.key = key;
+  h.levels = lv.size();
+  auto tmp = file;
+  tmp += ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out || !out.write((const char *)&h, sizeof(h))) return;
+    for (auto &level : lv) {
+      uint64_t count = level.size();
+      if (!out.write((const char *)&count, sizeof(count))) return;
+    }
+    for (auto &level : lv)
+      if (!out.write((const char *)level.data(), level.size() * sizeof(Peak))) return;
+  }
+  std::filesystem::rename(tmp, file, ec);
+  if (ec) {
+    std::filesystem::remove(tmp, ec);
+    return;
+  }
+  prune(dir, ".peaks", MaxFiles);
+  load(file, key, stop.get());
+}
+
+std::vector<PeakCache::Peak> PeakCache::columns(int count, double duration) {
+  std::lock_guard<std::mutex> l(lock);
+  std::vector<Peak> out;
+  if (levels.empty() || count <= 0 || duration <= 0) return out;
+
+  // seconds per peak doubles with each level
+  double column = duration / count, seconds = (double)BlockSize / SampleRate;
+  size_t level = 0;
+  while (level + 1 < levels.size() && seconds * 2 <= column) {
+    seconds *= 2;
+    level++;
+  }
+  auto [peaks, size] = levels[level];
+  out.resize(count, Peak{0, 0});
+  for (int c = 0; c < count; c++) {
+    size_t from = (size_t)(c * column / seconds), to = std::max(from + 1, (size_t)((c + 1) * column / seconds));
+    if (from >= size) break;
+    Peak p = peaks[from];
+    for (size_t i = from + 1; i < std::min(to, size); i++) {
+      p.min = std::min(p.min, peaks[i].min);
+      p.max = std::max(p.max, peaks[i].max);
+    }
+    out[c] = p;
+  }
+  return out;
+}
+}  // namespace ImPlay
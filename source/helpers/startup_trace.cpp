@@ -0,0 +1,24 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <algorithm>
+#include "helpers/startup_trace.h"
+
+namespace ImPlay {
+StartupTrace &StartupTrace::get() {
+  static StartupTrace trace;
+  return trace;
+}
+
+void StartupTrace::mark(const char *name) {
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  std::lock_guard<std::mutex> l(lock);
+  if (std::any_of(items.begin(), items.end(), [&](auto &item) { return item.first == name; })) return;
+  items.emplace_back(name, elapsed.count());
+}
+
+std::vector<std::pair<std::string, double>> StartupTrace::marks() {
+  std::lock_guard<std::mutex> l(lock);
+  return items;
+}
+}  // namespace ImPlay
@@ -0,0 +1,312 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <fmt/color.h>
+#include "helpers/thumbnailer.h"
+
+namespace ImPlay {
+using Clock = std::chrono::steady_clock;
+
+Thumbnailer::Thumbnailer(int maxWidth, int maxHeight) : maxWidth(maxWidth), maxHeight(maxHeight) {
+  ctx = mpv_create();
+  if (!ctx) throw std::runtime_error("could not create mpv handle");
+
+  mpv_set_option_string(ctx, "config", "no");
+  mpv_set_option_string(ctx, "terminal", "no");
+  mpv_set_option_string(ctx, "load-scripts", "no");
+  mpv_set_option_string(ctx, "ytdl", "no");
+  mpv_set_option_string(ctx, "vo", "libmpv");
+  mpv_set_option_string(ctx, "hwdec", "no");
+  mpv_set_option_string(ctx, "aid", "no");
+  mpv_set_option_string(ctx, "sid", "no");
+  mpv_set_option_string(ctx, "idle", "yes");
+  mpv_set_option_string(ctx, "pause", "yes");
+  mpv_set_option_string(ctx, "keep-open", "always");
+  // keyframes only, decoded as cheaply as possible, nothing read ahead
+  mpv_set_option_string(ctx, "hr-seek", "no");
+  mpv_set_option_string(ctx, "vd-lavc-skiploopfilter", "all");
+  mpv_set_option_string(ctx, "vd-lavc-fast", "yes");
+  mpv_set_option_string(ctx, "vd-lavc-threads", "2");
+  mpv_set_option_string(ctx, "cache", "no");
+  mpv_set_option_string(ctx, "demuxer-readahead-secs", "0");
+  mpv_set_option_string(ctx, "sws-scaler", "fast-bilinear");
+  if (mpv_initialize(ctx) < 0) {
+    mpv_terminate_destroy(ctx);
+    throw std::runtime_error("could not initialize mpv context");
+  }
+
+  mpv_render_param params[]{
+      {MPV_RENDER_PARAM_API_TYPE, const_cast<char *>(MPV_RENDER_API_TYPE_SW)},
+      {MPV_RENDER_PARAM_INVALID, nullptr},
+  };
+  if (mpv_render_context_create(&render, ctx, params) < 0) {
+    mpv_terminate_destroy(ctx);
+    throw std::runtime_error("failed to initialize mpv software render context");
+  }
+  mpv_render_context_set_update_callback(
+      render,
+      [](void *data) {
+        auto self = static_cast<Thumbnailer *>(data);
+        std::lock_guard<std::mutex> l(self->lock);
+        self->updated = true;
+        self->cond.notify_one();
+      },
+      this);
+}
+
+Thumbnailer::~Thumbnailer() {
+  mpv_render_context_free(render);
+  mpv_terminate_destroy(ctx);
+}
+
+bool Thumbnailer::waitEvent(mpv_event_id id, double timeout, bool endFails) {
+  auto deadline = Clock::now() + std::chrono::duration<double>(timeout);
+  while (Clock::now() < deadline) {
+    double left = std::chrono::duration<double>(deadline - Clock::now()).count();
+    mpv_event *event = mpv_wait_event(ctx, std::max(left, 0.0));
+    if (event->event_id == id) return true;
+    if ((endFails && event->event_id == MPV_EVENT_END_FILE) || event->event_id == MPV_EVENT_SHUTDOWN) return false;
+  }
+  return false;
+}
+
+bool Thumbnailer::waitFrame(double timeout) {
+  auto deadline = Clock::now() + std::chrono::duration<double>(timeout);
+  while (true) {
+    if (mpv_render_context_update(render) & MPV_RENDER_UPDATE_FRAME) return true;
+    std::unique_lock<std::mutex> l(lock);
+    if (!cond.wait_until(l, deadline, [this]() { return updated; })) return false;
+    updated = false;
+  }
+}
+
+bool Thumbnailer::load(const std::string &path) {
+  duration_ = 0;
+  const char *cmd[] = {"loadfile", path.c_str(), nullptr};
+  // the previous file ends first, only an end after this one started means it failed
+  if (mpv_command(ctx, cmd) < 0 || !waitEvent(MPV_EVENT_START_FILE, 10, false) ||
+      !waitEvent(MPV_EVENT_FILE_LOADED, 10))
+    return false;
+
+  char *vid = mpv_get_property_string(ctx, "vid");
+  bool video = vid != nullptr && std::string(vid) != "no";
+  mpv_free(vid);
+  mpv_get_property(ctx, "duration", MPV_FORMAT_DOUBLE, &duration_);
+  return video;
+}
+
+bool Thumbnailer::grab(double time, Frame &frame) {
+  if (time >= 0) {
+    auto pos = fmt::format("{:.3f}", time);
+    const char *cmd[] = {"seek", pos.c_str(), "absolute+keyframes", nullptr};
+    if (mpv_command(ctx, cmd) < 0 || !waitEvent(MPV_EVENT_PLAYBACK_RESTART, 5)) return false;
+  }
+  if (!waitFrame(2)) return false;
+
+  int64_t dw = 0, dh = 0;
+  mpv_get_property(ctx, "dwidth", MPV_FORMAT_INT64, &dw);
+  mpv_get_property(ctx, "dheight", MPV_FORMAT_INT64, &dh);
+  if (dw <= 0 || dh <= 0) return false;
+
+  // a width in multiples of 16 keeps the stride 64 byte aligned, as the software renderer prefers
+  double scale = std::min((double)maxWidth / dw, (double)maxHeight / dh);
+  int w = std::max(16, (int)(dw * scale) / 16 * 16), h = std::max(1, (int)std::lround(dh * scale));
+  size_t stride = (size_t)w * 4;
+  frame.width = w;
+  frame.height = h;
+  frame.pixels.resize(stride * h);
+
+  int size[] = {w, h};
+  mpv_render_param params[]{
+      {MPV_RENDER_PARAM_SW_SIZE, size},
+      {MPV_RENDER_PARAM_SW_FORMAT, const_cast<char *>("rgb0")},
+      {MPV_RENDER_PARAM_SW_STRIDE, &stride},
+      {MPV_RENDER_PARAM_SW_POINTER, frame.pixels.data()},
+      {MPV_RENDER_PARAM_INVALID, nullptr},
+  };
+  if (mpv_render_context_render(render, params) < 0) return false;
+  for (size_t i = 3; i < frame.pixels.size(); i += 4) frame.pixels[i] = 0xff;
+  return true;
+}
+
+ThumbnailAtlas::ThumbnailAtlas(int cols, int rows) : cols(cols), rows(rows), entries(cols * rows) {}
+
+void ThumbnailAtlas::newFrame() {
+  std::lock_guard<std::mutex> l(lock);
+  frame++;
+}
+
+bool ThumbnailAtlas::put(const std::string &key, Thumbnailer::Frame frame) {
+  std::lock_guard<std::mutex> l(lock);
+  int cell;
+  if (auto it = index.find(key); it != index.end()) {
+    cell = *it->second;
+    lru.erase(it->second);
+  } else if (lru.size() < entries.size()) {
+    cell = (int)lru.size();
+  } else {
+    // evicting a cell in view would only get it decoded again in the next frame
+    cell = lru.back();
+    if (inView(entries[cell])) return false;
+    lru.pop_back();
+    index.erase(entries[cell].key);
+  }
+  lru.push_front(cell);
+  index[key] = lru.begin();
+
+  auto &entry = entries[cell];
+  entry.key = key;
+  entry.width = std::min(frame.width, CellWidth);
+  entry.height = std::min(frame.height, CellHeight);
+  entry.pitch = frame.width;
+  entry.pixels = std::move(frame.pixels);
+  entry.uploaded = false;
+  entry.frame = this->frame;
+  return true;
+}
+
+bool ThumbnailAtlas::contains(const std::string &key) {
+  std::lock_guard<std::mutex> l(lock);
+  return index.find(key) != index.end();
+}
+
+bool ThumbnailAtlas::lookup(const std::string &key, Cell &cell) {
+  std::lock_guard<std::mutex> l(lock);
+  auto it = index.find(key);
+  if (it == index.end()) return false;
+  int i = *it->second;
+  auto &entry = entries[i];
+  entry.frame = frame;
+  lru.splice(lru.begin(), lru, it->second);
+  if (!entry.uploaded) return false;
+
+  float w = (float)(cols * CellWidth), h = (float)(rows * CellHeight);
+  float x = (float)(i % cols * CellWidth), y = (float)(i / cols * CellHeight);
+  cell.size = ImVec2((float)entry.width, (float)entry.height);
+  cell.uv0 = ImVec2(x / w, y / h);
+  cell.uv1 = ImVec2((x + entry.width) / w, (y + entry.height) / h);
+  return true;
+}
+
+int ThumbnailAtlas::available() {
+  std::lock_guard<std::mutex> l(lock);
+  return (int)std::count_if(entries.begin(), entries.end(), [this](const Entry &e) { return !inView(e); });
+}
+
+void ThumbnailAtlas::clear() {
+  std::lock_guard<std::mutex> l(lock);
+  index.clear();
+  lru.clear();
+  for (auto &entry : entries) entry = Entry();
+}
+
+void ThumbnailAtlas::upload() {
+  std::lock_guard<std::mutex> l(lock);
+  if (tex == 0 && index.empty()) return;
+  if (tex == 0) {
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, cols * CellWidth, rows * CellHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                 nullptr);
+  } else {
+    glBindTexture(GL_TEXTURE_2D, tex);
+  }
+  for (size_t i = 0; i < entries.size(); i++) {
+    auto &entry = entries[i];
+    if (entry.pixels.empty()) continue;
+    // rows are packed at the frame's own width, which may be wider than the cell
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, entry.pitch);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, (GLint)(i % cols * CellWidth), (GLint)(i / cols * CellHeight), entry.width,
+                    entry.height, GL_RGBA, GL_UNSIGNED_BYTE, entry.pixels.data());
+    std::vector<uint8_t>().swap(entry.pixels);
+    entry.uploaded = true;
+  }
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void ThumbnailAtlas::destroy() {
+  std::lock_guard<std::mutex> l(lock);
+  if (tex != 0) glDeleteTextures(1, &tex);
+  tex = 0;
+  index.clear();
+  lru.clear();
+  for (auto &entry : entries) entry = Entry();
+}
+
+ThumbnailPool::ThumbnailPool(ThumbnailAtlas &atlas, int workers) : atlas(atlas), workers(workers) {
+  // decoding is single threaded per worker, leave half the cores to playback
+  if (this->workers <= 0) this->workers = (int)std::clamp(std::thread::hardware_concurrency() / 2, 1u, 4u);
+}
+
+ThumbnailPool::~ThumbnailPool() {
+  {
+    std::lock_guard<std::mutex> l(lock);
+    quit = true;
+  }
+  cond.notify_all();
+  for (auto &thread : threads) thread.join();
+}
+
+void ThumbnailPool::request(const std::vector<std::string> &paths) {
+  std::lock_guard<std::mutex> l(lock);
+  queue.clear();
+  // more than fits would evict each other and be decoded over and over
+  size_t room = (size_t)std::max(atlas.available() - (int)busy.size(), 0);
+  for (auto &path : paths) {
+    if (queue.size() >= room) break;
+    if (!busy.count(path) && !failed_.count(path) && !atlas.contains(path)) queue.push_back(path);
+  }
+  if (queue.empty()) return;
+  while ((int)threads.size() < workers) threads.emplace_back(&ThumbnailPool::run, this);
+  cond.notify_all();
+}
+
+bool ThumbnailPool::failed(const std::string &path) {
+  std::lock_guard<std::mutex> l(lock);
+  return failed_.count(path) > 0;
+}
+
+void ThumbnailPool::clearFailed() {
+  std::lock_guard<std::mutex> l(lock);
+  failed_.clear();
+}
+
+void ThumbnailPool::run() {
+  std::unique_ptr<Thumbnailer> decoder;
+  std::unique_lock<std::mutex> l(lock);
+  while (true) {
+    cond.wait(l, [this]() { return quit || !queue.empty(); });
+    if (quit) break;
+    auto path = queue.front();
+    queue.pop_front();
+    busy.insert(path);
+    l.unlock();
+
+    Thumbnailer::Frame frame;
+    bool ok = false;
+    try {
+      if (!decoder) decoder = std::make_unique<Thumbnailer>(ThumbnailAtlas::CellWidth, ThumbnailAtlas::CellHeight);
+      // clips a little way in, past fades from black; images have no duration
+      if (decoder->load(path)) ok = decoder->grab(decoder->duration() > 0 ? decoder->duration() * 0.1 : -1, frame);
+    } catch (const std::exception &e) {
+      fmt::print(fg(fmt::color::red), "thumbnail: {}\n", e.what());
+    }
+
+    l.lock();
+    busy.erase(path);
+    if (ok) {
+      if (atlas.put(path, std::move(frame)) && updateCb) updateCb();
+    } else {
+      failed_.insert(path);
+    }
+  }
+}
+}  // namespace ImPlay
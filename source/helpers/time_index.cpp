@@ -0,0 +1,242 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <fmt/format.h>
+#include <mpv/client.h>
+#include "helpers/time_index.h"
+#include "helpers/utils.h"
+
+namespace ImPlay {
+constexpr char Magic[4] = {'I', 'P', 'K', 'F'};
+constexpr uint32_t Version = 2;
+constexpr size_t MaxFiles = 256;
+
+namespace {
+struct Header {
+  char magic[4];
+  uint32_t version;
+  uint64_t key;
+  uint64_t count;
+};  // followed by count doubles, in ascending order
+}  // namespace
+
+// libmpv can't demux without decoding, so keyframes are decoded as cheaply as lavc allows: the
+// rest is skipped, and so are the IDCT and loop filter, the pictures are never looked at; the
+// tiny scale keeps the frames that go through the filter graph small
+KeyframeIndex::KeyframeIndex(const std::filesystem::path &dir)
+    : TimeIndex(dir,
+                {
+                    {"vd-lavc-skipframe", "nonkey"},
+                    {"vd-lavc-skipidct", "all"},
+                    {"vd-lavc-skiploopfilter", "all"},
+                    {"vd-lavc-fast", "yes"},
+                },
+                "scale=32:-2:flags=fast_bilinear,") {}
+
+// scdet compares each frame with the previous one, 256px wide is plenty for that; only the
+// frames it tags as cuts are let through
+SceneIndex::SceneIndex(const std::filesystem::path &dir)
+    : TimeIndex(dir,
+                {
+                    {"vd-lavc-fast", "yes"},
+                    {"vd-lavc-skiploopfilter", "all"},
+                },
+                "scale=256:-2,scdet=threshold=10,metadata=select:lavfi.scd.time,") {}
+
+// the scans use this, wait for the cancelled ones to wind down
+TimeIndex::~TimeIndex() {
+  close();
+  std::unique_lock<std::mutex> l(lock);
+  idle.wait(l, [this]() { return running == 0; });
+}
+
+void TimeIndex::open(const std::string &path) {
+  close();
+  uint64_t key = fileKey(path);
+  auto file = dir / fmt::format("{:016x}.idx", key);
+  if (load(file, key)) return;
+
+  std::lock_guard<std::mutex> l(lock);
+  cancel = std::make_shared<std::atomic<bool>>(false);
+  running++;
+  // detached, destroying the headless mpv of a cancelled scan can take a while
+  std::thread([this, path, file, key, stop = cancel]() {
+    scan(path, file, key, stop);
+    std::lock_guard<std::mutex> l(lock);
+    running--;
+    idle.notify_all();
+  }).detach();
+}
+
+void TimeIndex::close() {
+  std::lock_guard<std::mutex> l(lock);
+  if (cancel) *cancel = true;
+  cancel.reset();
+  mapped.reset();
+  times = nullptr;
+  count = 0;
+}
+
+bool TimeIndex::load(const std::filesystem::path &file, uint64_t key, const std::atomic<bool> *stop) {
+  std::shared_ptr<const MappedFile> m;
+  try {
+    m = std::make_shared<const MappedFile>(file);
+  } catch (const std::exception &) {
+    return false;
+  }
+  Header h;
+  if (m->size() < sizeof(h)) return false;
+  memcpy(&h, m->data(), sizeof(h));
+  if (memcmp(h.magic, Magic, sizeof(Magic)) != 0 || h.version != Version || h.key != key) return false;
+  if (h.count == 0 || h.count != (m->size() - sizeof(h)) / sizeof(double)) return false;
+
+  // the header keeps the array 8 byte aligned in the page aligned mapping
+  std::lock_guard<std::mutex> l(lock);
+  if (stop != nullptr && *stop) return false;
+  times = reinterpret_cast<const double *>(m->data() + sizeof(h));
+  count = h.count;
+  mapped = std::move(m);
+  return true;
+}
+
+// libav logs only reach the first mpv instance, the player, so the metadata filter prints the
+// timestamps to a scratch file; in microseconds, pts_time only has 6 significant digits
+void TimeIndex::scan(std::string path, std::filesystem::path file, uint64_t key,
+                     std::shared_ptr<std::atomic<bool>> stop) {
+  lowerThreadPriority();
+  std::error_code ec;
+  auto out = createScratchFile(dir, fmt::format("{:016x}", key), ".txt");
+  if (out.empty()) return;
+  auto outPath = out.generic_u8string();
+  auto graph = fmt::format("{}settb=AVTB,metadata=add:implay.frame:1,metadata=print:implay.frame:file={}", filters,
+                           escapeLavfi("file:" + std::string(outPath.begin(), outPath.end())));
+  auto vf = fmt::format("lavfi=graph=%{}%{}", graph.size(), graph);  // mpv takes the next n bytes as they are
+
+  mpv_handle *ctx = mpv_create();
+  if (!ctx) {
+    std::filesystem::remove(out, ec);
+    return;
+  }
+  mpv_set_option_string(ctx, "config", "no");
+  mpv_set_option_string(ctx, "terminal", "no");
+  mpv_set_option_string(ctx, "load-scripts", "no");
+  mpv_set_option_string(ctx, "ytdl", "no");
+  mpv_set_option_string(ctx, "vo", "null");
+  mpv_set_option_string(ctx, "ao", "null");
+  mpv_set_option_string(ctx, "aid", "no");
+  mpv_set_option_string(ctx, "sid", "no");
+  mpv_set_option_string(ctx, "hwdec", "no");
+  mpv_set_option_string(ctx, "untimed", "yes");
+  mpv_set_option_string(ctx, "vd-lavc-threads", "1");
+  mpv_set_option_string(ctx, "demuxer-thread", "no");
+  // not every OS passes the priority on to mpv's threads, the core thread that decodes sends the events
+  mpv_set_wakeup_callback(ctx, [](void *) { lowerThreadPriority(); }, nullptr);
+  mpv_set_option_string(ctx, "vf", vf.c_str());
+  for (auto &[name, value] : options) mpv_set_option_string(ctx, name, value);
+  if (mpv_initialize(ctx) < 0) {
+    mpv_terminate_destroy(ctx);
+    std::filesystem::remove(out, ec);
+    return;
+  }
+  const char *cmd[] = {"loadfile", path.c_str(), nullptr};
+  mpv_command(ctx, cmd);
+
+  bool done = false, ok = false;
+  while (!done && !*stop) {
+    mpv_event *event = mpv_wait_event(ctx, 0.1);
+    switch (event->event_id) {
+      case MPV_EVENT_END_FILE: {
+        auto ef = (mpv_event_end_file *)event->data;
+        ok = ef->reason == MPV_END_FILE_REASON_EOF;
+        done = true;
+        break;
+      }
+      case MPV_EVENT_SHUTDOWN:
+        done = true;
+        break;
+      default:
+        break;
+    }
+  }
+  // closes the file
+  mpv_terminate_destroy(ctx);
+
+  std::vector<double> found;
+  if (ok && !*stop) {
+    std::ifstream in(out);
+    std::string line;
+    while (std::getline(in, line)) {
+      auto p = line.find(" pts:");
+      if (p == std::string::npos) continue;
+      const char *start = line.c_str() + p + strlen(" pts:");
+      char *end;
+      long long pts = strtoll(start, &end, 10);
+      if (end != start) found.push_back(pts / 1e6);  // NOPTS has no digits
+    }
+  }
+  std::filesystem::remove(out, ec);
+  if (!ok || *stop || found.empty()) return;
+
+  std::sort(found.begin(), found.end());
+  found.erase(std::unique(found.begin(), found.end()), found.end());
+  Header h{};
+  memcpy(h.magic, Magic, sizeof(Magic));
+  h.version = Version;
+  h.key = key;
+  h.count = found.size();
+
+  auto tmp = file;
+  tmp += ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out || !out.write((const char *)&h, sizeof(h)) ||
+        !out.write((const char *)found.data(), found.size() * sizeof(double)))
+      return;
+  }
+  std::filesystem::rename(tmp, file, ec);
+  if (ec) {
+    std::filesystem::remove(tmp, ec);
+    return;
+  }
+  prune(dir, ".idx", MaxFiles);
+  load(file, key, stop.get());
+}
+
+bool TimeIndex::ready() {
+  std::lock_guard<std::mutex> l(lock);
+  return count > 0;
+}
+
+double TimeIndex::snap(double time) {
+  std::lock_guard<std::mutex> l(lock);
+  if (count == 0) return time;
+  auto it = std::lower_bound(times, times + count, time);
+  if (it == times + count) return *(it - 1);
+  if (it != times && time - *(it - 1) < *it - time) return *(it - 1);
+  return *it;
+}
+
+double TimeIndex::before(double time) {
+  std::lock_guard<std::mutex> l(lock);
+  if (count == 0) return time;
+  auto it = std::upper_bound(times, times + count, time);
+  return it == times ? *it : *(it - 1);
+}
+
+double TimeIndex::after(double time) {
+  std::lock_guard<std::mutex> l(lock);
+  auto it = std::upper_bound(times, times + count, time);
+  return it == times + count ? -1 : *it;
+}
+
+std::vector<double> TimeIndex::all() {
+  std::lock_guard<std::mutex> l(lock);
+  return std::vector<double>(times, times + count);
+}
+}  // namespace ImPlay
@@ -2,16 +2,27 @@
 // SPDX-License-Identifier: GPL-2.0-only
 
 #include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <cctype>
 #include <cstring>
+#include <random>
+#include <fcntl.h>
 #ifdef _WIN32
 #include <windows.h>
 #include <shlobj.h>
+#include <io.h>
+#include <sys/stat.h>
 #elif defined(__APPLE__)
 #include <limits.h>
 #include <sysdir.h>
 #include <glob.h>
+#include <pthread.h>
+#include <unistd.h>
+#elif defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #endif
 #include "helpers/utils.h"
 
@@ -67,6 +78,87 @@ bool fileExists(std::string path) {
   return std::filesystem::exists(fp);
 }
 
+uint64_t fileKey(const std::string& path) {
+  uint64_t key = 14695981039346656037ull;
+  auto add = [&](const void* data, size_t size) {
+    auto p = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+      key ^= p[i];
+      key *= 1099511628211ull;
+    }
+  };
+  std::error_code ec;
+  auto p = std::filesystem::u8path(path);
+  auto size = (uint64_t)std::filesystem::file_size(p, ec);
+  auto mtime = (int64_t)std::filesystem::last_write_time(p, ec).time_since_epoch().count();
+  add(path.data(), path.size() + 1);
+  add(&size, sizeof(size));
+  add(&mtime, sizeof(mtime));
+  return key;
+}
+
+void prune(const std::filesystem::path& dir, const std::string& ext, size_t maxFiles) {
+  std::error_code ec;
+  std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::path>> files;
+  for (auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+    if (entry.path().extension() == ext) files.emplace_back(entry.last_write_time(ec), entry.path());
+  }
+  if (files.size() <= maxFiles) return;
+  std::sort(files.begin(), files.end(), [](auto& a, auto& b) { return a.first > b.first; });
+  for (size_t i = maxFiles; i < files.size(); i++) std::filesystem::remove(files[i].second, ec);
+}
+
+std::filesystem::path createScratchFile(const std::filesystem::path& dir, const std::string& prefix,
+                                        const std::string& ext) {
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+  auto stale = std::filesystem::file_time_type::clock::now() - std::chrono::hours(1);
+  for (auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+    if (entry.path().extension() == ext && entry.last_write_time(ec) < stale) std::filesystem::remove(entry.path(), ec);
+  }
+
+  // O_EXCL neither follows nor reuses what is already there
+  std::random_device rd;
+  for (int i = 0; i < 4; i++) {
+    auto file = dir / fmt::format("{}-{:08x}{}", prefix, rd(), ext);
+#ifdef _WIN32
+    int fd = _wopen(file.c_str(), _O_WRONLY | _O_CREAT | _O_EXCL | _O_BINARY, _S_IREAD | _S_IWRITE);
+    if (fd < 0) continue;
+    _close(fd);
+#else
+    int fd = ::open(file.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0) continue;
+    ::close(fd);
+#endif
+    return file;
+  }
+  return {};
+}
+
+std::string escapeLavfi(const std::string& value) {
+  std::string option, graph;
+  for (char c : value) {
+    if (c == '\\' || c == '\'' || c == ':') option += '\\';
+    option += c;
+  }
+  for (char c : option) {
+    if (c == '\\' || c == '\'' || c == '[' || c == ']' || c == ',' || c == ';') graph += '\\';
+    graph += c;
+  }
+  return graph;
+}
+
+void lowerThreadPriority() {
+#ifdef _WIN32
+  SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#elif defined(__APPLE__)
+  pthread_set_qos_class_self_np(QOS_CLASS_BACKGROUND, 0);
+#elif defined(__linux__)
+  // linux threads have their own nice value
+  setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), 19);
+#endif
+}
+
 int openUrl(std::string url) {
 #ifdef __APPLE__
   return system(fmt::format("open '{}'", url).c_str());
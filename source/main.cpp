@@ -3,15 +3,15 @@
 
 #include <cstring>
 #include <stdexcept>
+#include <filesystem>
+#include <fstream>
 #ifdef _WIN32
 #include <windows.h>
-#else
-#include <unistd.h>
-#include <sys/types.h>
-#include <sys/socket.h>
-#include <sys/un.h>
 #endif
 #include <nlohmann/json.hpp>
+#include "helpers/batch_encode.h"
+#include "helpers/ipc.h"
+#include "helpers/startup_trace.h"
 #include "helpers/utils.h"
 #include "window.h"
 
@@ -26,6 +26,12 @@ static const char* usage =
     " --sub-file=<file> specify subtitle file to use\n"
     " --playlist=<file> specify playlist file\n"
     "\n"
+    "Batch encoding:\n"
+    " --o=<pattern>           encode each file on its own, e.g. --o=out/{name}.mp4\n"
+    "                         ({name}, {dir} and {index} are replaced per file)\n"
+    " --batch-jobs=<n>        number of files encoded at once (default: cores / 4)\n"
+    " --batch-summary=<file>  write the JSON summary to file instead of stdout\n"
+    "\n"
     "Visit https://mpv.io/manual/stable to get full mpv options.\n";
 
 static int run_headless(ImPlay::OptionParser& parser) {
@@ -55,53 +61,51 @@ static int run_headless(ImPlay::OptionParser& parser) {
   return 0;
 }
 
-static std::string build_ipc_cmd(std::string path) {
-  nlohmann::json j = {{"command", {"loadfile", path, "append-play"}}};
-  return fmt::format("{}\n", j.dump());
-}
-
-#ifdef _WIN32
-static bool send_ipc(std::string sock, std::vector<std::string> paths) {
-  HANDLE hPipe = CreateFile(sock.c_str(), GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
-  if (hPipe == INVALID_HANDLE_VALUE) return false;
-
-  for (auto& path : paths) {
-    std::string payload = build_ipc_cmd(path);
-    if (!WriteFile(hPipe, payload.c_str(), payload.size(), NULL, NULL)) {
-      fmt::print("WriteFile failed: {}, payload: {}\n", GetLastError(), payload);
-    }
+static int run_batch(ImPlay::OptionParser& parser) {
+  auto options = parser.options;
+  int jobs = 0;
+  std::string summaryPath;
+  if (auto it = options.find("batch-jobs"); it != options.end()) {
+    jobs = std::stoi(it->second);
+    options.erase(it);
+  }
+  if (auto it = options.find("batch-summary"); it != options.end()) {
+    summaryPath = it->second;
+    options.erase(it);
   }
 
-  CloseHandle(hPipe);
-  return true;
+  ImPlay::BatchEncoder encoder(options, parser.options["o"], jobs);
+  auto summary = encoder.run(parser.paths);
+  if (summaryPath.empty())
+    fmt::print("{}\n", summary.dump(2));
+  else
+    std::ofstream(std::filesystem::u8path(summaryPath)) << summary.dump(2) << "\n";
+  return summary["failed"] == 0 ? 0 : 1;
 }
-#else
-static bool send_ipc(std::string sock, std::vector<std::string> paths) {
-  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
-  if (fd == -1) return false;
-
-  struct sockaddr_un addr;
-  addr.sun_family = AF_UNIX;
-  strncpy(addr.sun_path, sock.c_str(), sizeof(addr.sun_path) - 1);
-
-  if ((connect(fd, (struct sockaddr*)&addr, sizeof(addr))) == -1) {
-    close(fd);
-    return false;
-  }
 
+// Hands the paths to the running instance in one request, it adds them to the playlist at
+// once and acknowledges with the playlist positions. Returns false if no instance listens.
+static bool send_ipc(std::string sock, std::vector<std::string> paths) {
   for (auto& path : paths) {
-    std::string payload = build_ipc_cmd(path);
-    if (write(fd, payload.c_str(), payload.size()) == -1) {
-      fmt::print("write failed: {}, payload: {}\n", errno, payload);
-    }
+    if (path == "-" || path.find("://") != std::string::npos) continue;
+    std::error_code ec;
+    auto abs = std::filesystem::absolute(std::filesystem::u8path(path), ec).u8string();
+    if (!ec) path = std::string(abs.begin(), abs.end());
   }
-
-  close(fd);
+  nlohmann::json req = {{"command", "open"}, {"paths", paths}, {"request_id", 1}};
+  auto reply = ImPlay::ipcRequest(sock, req.dump(), 5000);
+  if (!reply) return false;
+
+  auto res = nlohmann::json::parse(*reply, nullptr, false);
+  if (res.is_discarded() || !res.is_object())
+    fmt::print(fg(fmt::color::yellow), "No reply from the running instance\n");
+  else if (res.value("error", "") != "success")
+    fmt::print(fg(fmt::color::red), "ipc: {}\n", res.value("error", ""));
   return true;
 }
-#endif
 
 int main(int argc, char* argv[]) {
+  ImPlay::StartupTrace::get().mark("main");
 #ifdef _WIN32
   char* console = getenv("_started_from_console");
   if (console != nullptr && strcmp(console, "yes") == 0) {
@@ -121,13 +125,16 @@ int main(int argc, char* argv[]) {
   }
 
   try {
+    if (parser.options.contains("o") && ImPlay::BatchEncoder::isPattern(parser.options["o"]))
+      return run_batch(parser);
     if (parser.options.contains("o") || parser.check("video", "no") || parser.check("vid", "no"))
       return run_headless(parser);
 
     ImPlay::Config config;
     config.load();
+    ImPlay::StartupTrace::get().mark("config");
 
-    if (config.Data.Window.Single && send_ipc(config.ipcSocket(), parser.paths)) return 0;
+    if (config.Data.Window.Single && send_ipc(config.handoffSocket(), parser.paths)) return 0;
 
     ImPlay::Window window(&config);
     if (!window.init(parser)) return 1;
@@ -1,11 +1,13 @@
 // Copyright (c) 2022-2023 tsl0922. All rights reserved.
 // SPDX-License-Identifier: GPL-2.0-only
 
+#include <chrono>
 #include <stdexcept>
 #include <string>
 #include <thread>
 #include <cstdarg>
 #include <cstring>
+#include <fmt/format.h>
 #include <nlohmann/json.hpp>
 #include "mpv.h"
 
@@ -18,8 +20,19 @@ Mpv::Mpv() {
 }
 
 Mpv::~Mpv() {
+  if (eventThread.joinable()) {
+    eventQuit = true;
+    mpv_wakeup(main);
+    eventThread.join();
+  }
+  if (logThread.joinable()) {
+    logQuit = true;
+    mpv_wakeup(log);
+    logThread.join();
+  }
   if (renderCtx != nullptr) mpv_render_context_free(renderCtx);
   mpv_unobserve_property(mpv, 0);
+  if (log != nullptr) mpv_destroy(log);
   mpv_destroy(main);
   mpv_destroy(mpv);
 }
@@ -34,6 +47,13 @@ int Mpv::commandv(const char *arg, ...) {
   return mpv_command_async(mpv, 0, args.data());
 }
 
+int Mpv::commandSync(const std::vector<std::string> &args) {
+  std::vector<const char *> argv;
+  for (auto &arg : args) argv.push_back(arg.c_str());
+  argv.push_back(nullptr);
+  return mpv_command(mpv, argv.data());
+}
+
 void Mpv::waitEvent(double timeout) {
   while (mpv) {
     mpv_event *event = mpv_wait_event(mpv, timeout);
@@ -45,27 +65,62 @@ void Mpv::waitEvent(double timeout) {
           if (name == prop->name && format == prop->format) handler(prop->data);
         break;
       }
-      case MPV_EVENT_LOG_MESSAGE: {
-        mpv_event_log_message *msg = (mpv_event_log_message *)event->data;
-        if (logHandler) logHandler(msg->prefix, msg->level, msg->text);
-      } break;
       default:
         for (const auto &[event_id, handler] : events)
           if (event_id == event->event_id) handler(event->data);
         break;
     }
   }
+
+  if (!logQueue) return;
+  LogMessage msg;
+  logWoken = false;
+  for (size_t n = 0; n < LogBatch && logQueue->pop(msg); n++)
+    if (logHandler) logHandler(msg.prefix.c_str(), msg.level.c_str(), msg.text.c_str());
 }
 
 void Mpv::requestLog(const char *level, LogHandler handler) {
+  startLog();
   this->logHandler = handler;
-  mpv_request_log_messages(mpv, level);
+  mpv_request_log_messages(log, level);
+}
+
+void Mpv::logToFile(const std::filesystem::path &path, size_t maxSize) {
+  logFile = std::make_unique<LogFile>(path, maxSize);
+  startLog();
+}
+
+// most instances never ask for logs, the video wall tiles and the compare core among them
+void Mpv::startLog() {
+  if (log != nullptr) return;
+  log = mpv_create_client(main, "implay-log");
+  if (!log) throw std::runtime_error("could not create mpv log client");
+  logQueue = std::make_unique<SpscQueue<LogMessage>>(8192);
+  logThread = std::thread(&Mpv::logLoop, this);
+}
+
+void Mpv::logLoop() {
+  auto start = std::chrono::steady_clock::now();
+  while (!logQuit) {
+    mpv_event *event = mpv_wait_event(log, -1);
+    if (event->event_id == MPV_EVENT_SHUTDOWN) break;
+    if (event->event_id != MPV_EVENT_LOG_MESSAGE) continue;
+
+    auto msg = (mpv_event_log_message *)event->data;
+    if (logFile) {
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      logFile->write(fmt::format("[{:10.3f}][{}][{}] {}", elapsed.count(), msg->level, msg->prefix, msg->text));
+    }
+    // never wait for the UI, a full queue means the line is lost
+    if (!logQueue->push({msg->prefix, msg->level, msg->text})) logDropped++;
+    if (logQueue->size() >= logQueue->capacity() / 2 && !logWoken.exchange(true) && wakeupCb_) wakeupCb_(this);
+  }
 }
 
 int Mpv::loadConfig(const char *path) { return mpv_load_config_file(mpv, path); }
 
 void Mpv::eventLoop() {
-  while (main) {
+  while (!eventQuit) {
     mpv_event *event = mpv_wait_event(main, -1);
     if (event->event_id == MPV_EVENT_SHUTDOWN) break;
   }
@@ -94,9 +149,19 @@ void Mpv::reportSwap() {
 
 static void *get_proc_address(void *ctx, const char *name) { return ((GLAddrLoadFunc)ctx)(name); }
 
-void Mpv::init(GLAddrLoadFunc load, int64_t wid) {
+void Mpv::init(int64_t wid) {
+  this->wid = wid;
   if (mpv_set_property(mpv, "wid", MPV_FORMAT_INT64, &wid) < 0) throw std::runtime_error("could not set mpv wid");
   if (mpv_initialize(mpv) < 0) throw std::runtime_error("could not initialize mpv context");
+
+  mpv_request_log_messages(main, "no");
+  eventThread = std::thread(&Mpv::eventLoop, this);
+
+  forceWindow = property<int, MPV_FORMAT_FLAG>("force-window");
+  observeProperties();
+}
+
+void Mpv::initRender(GLAddrLoadFunc load) {
   if (wid == 0) {
     mpv_opengl_init_params gl_init_params{get_proc_address, (void *)load};
     mpv_render_param params[]{
@@ -117,8 +182,7 @@ void Mpv::init(GLAddrLoadFunc load, int64_t wid) {
         this);
   }
 
-  mpv_request_log_messages(main, "no");
-
+  // the window exists now, events may wake it up
   mpv_set_wakeup_callback(
       mpv,
       [](void *ctx) {
@@ -126,10 +190,6 @@ void Mpv::init(GLAddrLoadFunc load, int64_t wid) {
         if (mpv->wakeupCb_) mpv->wakeupCb_(mpv);
       },
       this);
-  std::thread(&Mpv::eventLoop, this).detach();
-
-  forceWindow = property<int, MPV_FORMAT_FLAG>("force-window");
-  observeProperties();
 }
 
 void Mpv::observeProperties() {
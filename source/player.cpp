@@ -1,18 +1,21 @@
 // Copyright (c) 2022-2023 tsl0922. All rights reserved.
 // SPDX-License-Identifier: GPL-2.0-only
 
+#include <cmath>
 #include <filesystem>
 #include <fstream>
 #include <thread>
 #include <romfs/romfs.hpp>
+#include <nlohmann/json.hpp>
 #include <imgui.h>
 #include <imgui_internal.h>
 #include <imgui_impl_opengl3.h>
-#include <fonts/cascadia.h>
 #include <fonts/fontawesome.h>
 #include <fonts/unifont.h>
 #include <strnatcmp.h>
 #include "theme.h"
+#include "helpers/font_cache.h"
+#include "helpers/startup_trace.h"
 #include "player.h"
 
 namespace ImPlay {
@@ -21,55 +24,118 @@ Player::Player(Config *config) : config(config) {
 
   about = new Views::About();
   debug = new Views::Debug(config, mpv);
+  logViewer = new Views::LogViewer(config, mpv);
   quickview = new Views::Quickview(config, mpv);
   settings = new Views::Settings(config, mpv);
   contextMenu = new Views::ContextMenu(config, mpv);
   commandPalette = new Views::CommandPalette(config, mpv);
+  commandPalette->setFileFilter([this](const std::string &name) { return isMediaFile(tolower(name)); });
+  videoWall = new Views::VideoWall(config, mpv);
+  // tiles share the render thread with the main video
+  videoWall->updateCb = [this]() {
+    if (mpv->updateCb()) mpv->updateCb()(mpv);
+  };
+  videoWall->exitCb = [this](std::string path) {
+    closeWall();
+    if (path.empty()) return;
+    auto it = std::find_if(mpv->playlist.begin(), mpv->playlist.end(),
+                           [&](auto &item) { return item.path.string() == path; });
+    if (it != mpv->playlist.end())
+      mpv->commandv("playlist-play-index", std::to_string(it - mpv->playlist.begin()).c_str(), nullptr);
+    else
+      mpv->commandv("loadfile", path.c_str(), nullptr);
+    mpv->command("set pause no");
+  };
+  compare = new Views::Compare(config, mpv);
+  compare->updateCb = videoWall->updateCb;
+  compare->redrawCb = [this]() {
+    redrawVideo = true;
+    if (mpv->updateCb()) mpv->updateCb()(mpv);
+  };
+  keyframes = new KeyframeIndex(std::filesystem::path(config->dir()) / "keyframes");
+  seekPreview = new Views::SeekPreview(config, mpv);
+  seekPreview->keyframes = keyframes;
+  seekPreview->updateCb = [this]() {
+    if (mpv->wakeupCb()) mpv->wakeupCb()(mpv);
+  };
+  quickview->updateCb = seekPreview->updateCb;
+  scenes = new SceneIndex(std::filesystem::path(config->dir()) / "scenes");
+  waveform = new Views::Waveform(config, mpv);
+  waveform->scenes = scenes;
+  commandPalette->scenes = scenes;
+  loudness = new LoudnessScanner(std::filesystem::path(config->dir()) / "loudness");
+  loudness->resultCb = [this](const std::string &path) {
+    mpv->commandv("script-message-to", "implay", "loudness-update", path.c_str(), nullptr);
+  };
 }
 
 Player::~Player() {
+  if (started.valid()) started.wait();
+  delete controlServer;
+  delete ipcServer;
   delete about;
   delete debug;
+  delete logViewer;
   delete quickview;
   delete settings;
   delete contextMenu;
   delete commandPalette;
+  delete videoWall;
+  delete compare;
+  delete seekPreview;
+  delete waveform;
+  delete keyframes;
+  delete scenes;
+  delete loudness;
   delete mpv;
 }
 
-bool Player::init(std::map<std::string, std::string> &options) {
-  mpv->option("config", "yes");
-  mpv->option("input-default-bindings", "yes");
-  mpv->option("input-vo-keyboard", "yes");
-  mpv->option("load-osd-console", "no");
-  mpv->option("osd-playing-msg", "${media-title}");
-  mpv->option("screenshot-directory", "~~desktop/");
+void Player::start(std::map<std::string, std::string> options) {
+  int refreshRate = GetMonitorRefreshRate();
+  int64_t wid = config->Data.Mpv.UseWid ? GetWid() : 0;
+  started = std::async(std::launch::async, [this, options, wid, refreshRate]() {
+    mpv->option("config", "yes");
+    mpv->option("input-default-bindings", "yes");
+    mpv->option("input-vo-keyboard", "yes");
+    mpv->option("load-osd-console", "no");
+    mpv->option("osd-playing-msg", "${media-title}");
+    mpv->option("screenshot-directory", "~~desktop/");
+
+    // override-display-fps is renamed to display-fps-override in mpv 0.37.0
+    mpv->option<int64_t, MPV_FORMAT_INT64>("override-display-fps", refreshRate);
+    mpv->option<int64_t, MPV_FORMAT_INT64>("display-fps-override", refreshRate);
+
+    if (!config->Data.Mpv.UseConfig) {
+      writeMpvConf();
+      mpv->option("osc", "no");
+      mpv->option("config-dir", config->dir().c_str());
+    }
 
-  // override-display-fps is renamed to display-fps-override in mpv 0.37.0
-  mpv->option<int64_t, MPV_FORMAT_INT64>("override-display-fps", GetMonitorRefreshRate());
-  mpv->option<int64_t, MPV_FORMAT_INT64>("display-fps-override", GetMonitorRefreshRate());
+    if (config->Data.Window.Single) mpv->option("input-ipc-server", config->ipcSocket().c_str());
 
-  if (!config->Data.Mpv.UseConfig) {
-    writeMpvConf();
-    mpv->option("osc", "no");
-    mpv->option("config-dir", config->dir().c_str());
-  }
+    for (const auto &[key, value] : options) {
+      if (int err = mpv->option(key.c_str(), value.c_str()); err < 0) {
+        fmt::print(fg(fmt::color::red), "mpv: {} [{}={}]\n", mpv_error_string(err), key, value);
+        return false;
+      }
+    }
 
-  if (config->Data.Window.Single) mpv->option("input-ipc-server", config->ipcSocket().c_str());
+    if (config->Data.Debug.LogFile)
+      mpv->logToFile(std::filesystem::path(config->dir()) / "implay.log",
+                     (size_t)std::max(config->Data.Debug.LogFileSize, 1) * 1024 * 1024);
+    mpv->init(wid);
+    StartupTrace::get().mark("mpv");
+    return true;
+  });
+}
 
-  for (const auto &[key, value] : options) {
-    if (int err = mpv->option(key.c_str(), value.c_str()); err < 0) {
-      fmt::print(fg(fmt::color::red), "mpv: {} [{}={}]\n", mpv_error_string(err), key, value);
-      return false;
-    }
-  }
+bool Player::init() {
+  if (!started.get()) return false;
 
   debug->init();
-
   {
     ContextGuard guard(this);
-    logoTexture = ImGui::LoadTexture("icon.png");
-    mpv->init(GetGLAddrFunc(), GetWid());
+    mpv->initRender(GetGLAddrFunc());
   }
 
   SetWindowDecorated(mpv->property<int, MPV_FORMAT_FLAG>("border"));
@@ -77,19 +143,33 @@ bool Player::init(std::map<std::string, std::string> &options) {
   if (config->Data.Recent.SpaceToPlayLast) mpv->command("keybind SPACE 'script-message-to implay play-pause'");
   initObservers();
 
+  if (config->Data.Window.Single) {
+    ipcServer = new IpcServer(config->handoffSocket(), [this](const std::string &req) { return handleIpc(req); });
+    if (!ipcServer->start()) fmt::print(fg(fmt::color::yellow), "Failed to listen on {}\n", config->handoffSocket());
+  }
+  if (config->Data.Control.Enabled) initControl();
+
   return true;
 }
 
 void Player::draw() {
-  drawVideo();
+  if (videoWall->active())
+    videoWall->draw();
+  else
+    drawVideo();
+  waveform->draw();
+  seekPreview->draw();
 
   about->draw();
   debug->draw();
+  logViewer->draw();
   quickview->draw();
   settings->draw();
   contextMenu->draw();
   commandPalette->draw();
 
+  compare->draw();
+
   drawOpenURL();
   drawDialog();
 }
@@ -100,7 +180,10 @@ void Player::drawVideo() {
 
   if (!idle) {
     ImTextureID texture = reinterpret_cast<ImTextureID>(static_cast<intptr_t>(tex));
-    drawList->AddImage(texture, vp->WorkPos, vp->WorkPos + vp->WorkSize);
+    if (compare->active())
+      compare->drawVideo(texture);
+    else
+      drawList->AddImage(texture, vp->WorkPos, vp->WorkPos + vp->WorkSize);
   } else if (logoTexture != nullptr && !mpv->forceWindow) {
     const ImVec2 center = vp->GetWorkCenter();
     const ImVec2 delta(64, 64);
@@ -123,12 +206,23 @@ void Player::render() {
     }
 
     if (config->FontReload) {
-      loadFonts();
+      loadFonts(!glyphsFull);
       ImGui_ImplOpenGL3_DestroyFontsTexture();
       ImGui_ImplOpenGL3_CreateFontsTexture();
-      config->FontReload = false;
+      config->FontReload = glyphsFull = false;
     }
+    seekPreview->render();
+    quickview->render();
     ImGui_ImplOpenGL3_NewFrame();
+
+    // glyphs seen in new text are drawn into cells set aside in the font texture, the atlas is only rebuilt
+    // once they run out; that one isn't cached, its key has glyphs of this session that may never be seen again
+    if (!config->PendingGlyphs.empty()) {
+      if (glyphs.add(config->PendingGlyphs))
+        config->PendingGlyphs.clear();
+      else
+        config->FontReload = glyphsFull = true;
+    }
   }
 
   BackendNewFrame();
@@ -182,15 +276,69 @@ void Player::render() {
 void Player::renderVideo() {
   ContextGuard guard(this);
 
+  // the GPU finishes the mirror's read of tex before this writes it, the thread doesn't wait
+  if (blitFence != nullptr) {
+    glWaitSync(blitFence, 0, GL_TIMEOUT_IGNORED);
+    glDeleteSync(blitFence);
+    blitFence = nullptr;
+  }
+
   glBindFramebuffer(GL_FRAMEBUFFER, fbo);
   glBindTexture(GL_TEXTURE_2D, tex);
 
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  int w = compare->sideBySide() ? width / 2 : width;
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
 
   glBindTexture(GL_TEXTURE_2D, 0);
   glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-  mpv->render(width, height, fbo, false);
+  mpv->render(w, height, fbo, false);
+  videoWidth = w;
+  videoHeight = height;
+  if (!idle) StartupTrace::get().mark("first-frame");
+}
+
+// Copies the video into the default framebuffer of the calling thread's context, fitted
+// to w x h. The caller's context shares tex with the player's, readFbo belongs to it.
+void Player::blitVideo(GLuint readFbo, int w, int h) {
+  std::lock_guard<std::mutex> lock(contextLock);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(0, 0, w, h);
+  glClearColor(0, 0, 0, 1);
+  glClear(GL_COLOR_BUFFER_BIT);
+
+  double aspect = videoAspect;
+  if (!idle && aspect > 0 && videoWidth > 0 && videoHeight > 0 && w > 0 && h > 0) {
+    // tex holds the video letterboxed to the player's size, crop the bars and letterbox it again
+    auto fit = [aspect](int w, int h, int &x, int &y, int &fw, int &fh) {
+      fw = w > h * aspect ? (int)(h * aspect) : w;
+      fh = w > h * aspect ? h : (int)(w / aspect);
+      x = (w - fw) / 2;
+      y = (h - fh) / 2;
+    };
+    int sx, sy, sw, sh, dx, dy, dw, dh;
+    fit(videoWidth, videoHeight, sx, sy, sw, sh);
+    fit(w, h, dx, dy, dw, dh);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, readFbo);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+    // tex is top-down, the window bottom-up
+    glBlitFramebuffer(sx, sy, sx + sw, sy + sh, dx, dy + dh, dx + dw, dy, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+  }
+  // the render thread waits on this before writing tex again; flushed so its context sees it
+  if (blitFence != nullptr) glDeleteSync(blitFence);
+  blitFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  glFlush();
+}
+
+// the video wall and the comparison video share the video render thread
+bool Player::renderCores() {
+  if (!videoWall->active() && !compare->active()) return false;
+  ContextGuard guard(this);
+  bool wall = videoWall->render();
+  bool other = compare->render();
+  return wall || other;
 }
 
 void Player::initGui() {
@@ -204,7 +352,7 @@ void Player::initGui() {
   SetSwapInterval(1);
 
   IMGUI_CHECKVERSION();
-  ImGui::CreateContext();
+  ImGui::CreateContext(fontAtlas.get());
 
   ImGuiIO &io = ImGui::GetIO();
   io.IniFilename = nullptr;
@@ -217,7 +365,11 @@ void Player::initGui() {
   if (config->Data.Interface.Viewports || config->Data.Mpv.UseWid) io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;
 #endif
 
-  loadFonts();
+  if (fontsBuilt.valid())
+    loadStyle(fontsBuilt.get());
+  else
+    loadFonts();
+  logoTexture = ImGui::LoadTexture("icon.png");
 
   glGenFramebuffers(1, &fbo);
   glGenTextures(1, &tex);
@@ -246,6 +398,11 @@ void Player::exitGui() {
   MakeContextCurrent();
 
   ImGui_ImplOpenGL3_Shutdown();
+  videoWall->close();
+  compare->close();
+  seekPreview->close();
+  quickview->close();
+  if (blitFence != nullptr) glDeleteSync(blitFence);
   glDeleteTextures(1, &tex);
   glDeleteFramebuffers(1, &fbo);
 
@@ -278,20 +435,40 @@ void Player::restoreState() {
   SetWindowPos(x, y);
 }
 
-void Player::loadFonts() {
-  auto interface = config->Data.Interface;
-  float fontSize = config->Data.Font.Size;
-  float iconSize = fontSize - 2;
-  float scale = interface.Scale;
+// the bundled subsets only cover the UI text, any other character needs the full font
+static bool subsetCovers(const romfs::Resource &ranges, const ImWchar *wanted) {
+  ImFontGlyphRangesBuilder covered;
+  auto data = ranges.data<uint8_t>();
+  auto u32 = [&](size_t o) { return (uint32_t)(data[o] | data[o + 1] << 8 | data[o + 2] << 16 | data[o + 3] << 24); };
+  for (size_t o = 0; o + 8 <= ranges.size(); o += 8) {
+    for (uint32_t c = u32(o); c <= u32(o + 4) && c <= IM_UNICODE_CODEPOINT_MAX; c++) covered.SetBit(c);
+  }
+  for (; wanted[0] != 0; wanted += 2) {
+    for (uint32_t c = wanted[0]; c <= wanted[1]; c++)
+      if (!covered.GetBit(c)) return false;
+  }
+  return true;
+}
+
+static void addRomfsFont(ImFontAtlas *atlas, const romfs::Resource &font, float size, const ImFontConfig *base,
+                         const ImWchar *ranges) {
+  ImFontConfig cfg = base != nullptr ? *base : ImFontConfig();
+  cfg.FontDataOwnedByAtlas = false;
+  atlas->AddFontFromMemoryTTF((void *)font.data(), (int)font.size(), size, &cfg, ranges);
+}
+
+float Player::fontScale() {
+  float scale = config->Data.Interface.Scale;
   if (scale == 0) {
     float xscale, yscale;
     GetWindowScale(&xscale, &yscale);
     scale = std::max(xscale, yscale);
   }
-  if (scale <= 0) scale = 1.0f;
-  fontSize = std::floor(fontSize * scale);
-  iconSize = std::floor(iconSize * scale);
+  return scale > 0 ? scale : 1.0f;
+}
 
+void Player::loadStyle(float scale) {
+  auto interface = config->Data.Interface;
   ImGuiStyle style;
   ImGui::SetTheme(interface.Theme.c_str(), &style, interface.Rounding, interface.Shadow);
 
@@ -306,25 +483,82 @@ void Player::loadFonts() {
   style.ScaleAllSizes(scale);
 #endif
   ImGui::GetStyle() = style;
+}
 
-  io.Fonts->Clear();
+void Player::loadFonts(bool save) {
+  float scale = fontScale();
+  loadStyle(scale);
+  buildFonts(ImGui::GetIO().Fonts, scale, save);
+}
+
+// the window is needed for its scale only, the atlas itself is built without the ImGui context
+void Player::startFonts() {
+  float scale = fontScale();
+  fontsBuilt = std::async(std::launch::async, [this, scale]() {
+    buildFonts(fontAtlas.get(), scale, true);
+    return scale;
+  });
+}
+
+void Player::buildFonts(ImFontAtlas *atlas, float scale, bool save) {
+  float fontSize = std::floor(config->Data.Font.Size * scale);
+  float iconSize = std::floor((config->Data.Font.Size - 2) * scale);
+
+  atlas->Clear();
 
   ImFontConfig cfg;
   cfg.SizePixels = fontSize;
 
-  const ImWchar *font_range = config->buildGlyphRanges();
-  if (fileExists(config->Data.Font.Path))
-    io.Fonts->AddFontFromFileTTF(config->Data.Font.Path.c_str(), 0, &cfg, font_range);
+  const ImWchar *font_range = config->buildGlyphRanges(atlas);
+  bool customFont = fileExists(config->Data.Font.Path);
+  auto &unifont = romfs::get("fonts/unifont.ttf");
+  auto &fa = romfs::get("fonts/fontawesome.ttf");
+  auto &cascadia = romfs::get("fonts/cascadia.ttf");
+  bool fullUnifont = !customFont && !subsetCovers(romfs::get("fonts/unifont.ranges"), font_range);
+
+  FontCache cache(std::filesystem::path(config->dir()) / "fonts");
+  cache.add(IMGUI_VERSION_NUM);
+  cache.add(atlas->FontBuilderFlags);
+  if (customFont) cache.addFile(config->Data.Font.Path);
+  cache.add(fullUnifont ? unifont_compressed_size : unifont.size());
+  cache.add(fa.size());
+  cache.add(cascadia.size());
+  cache.add(fontSize);
+  cache.add(iconSize);
+  cache.add(scale);
+  cache.add(font_range);
+  cache.add(GlyphLoader::Cells);
+
+  // glyphs added later come from the full font, the atlas may hold a subset of it
+  glyphs.reset(atlas, fontSize, [customFont, path = config->Data.Font.Path, fontSize]() {
+    ImFontAtlas atlas;  // only reads the file, or decompresses the font
+    if (customFont)
+      atlas.AddFontFromFileTTF(path.c_str(), fontSize);
+    else
+      atlas.AddFontFromMemoryCompressedTTF(unifont_compressed_data, unifont_compressed_size, fontSize);
+    if (atlas.ConfigData.empty()) return std::vector<unsigned char>();
+    auto data = (const unsigned char *)atlas.ConfigData[0].FontData;
+    return std::vector<unsigned char>(data, data + atlas.ConfigData[0].FontDataSize);
+  });
+  if (cache.load(atlas)) return;
+
+  GlyphLoader::reserve(atlas, fontSize);
+
+  if (customFont)
+    atlas->AddFontFromFileTTF(config->Data.Font.Path.c_str(), 0, &cfg, font_range);
+  else if (fullUnifont)
+    atlas->AddFontFromMemoryCompressedTTF(unifont_compressed_data, unifont_compressed_size, 0, &cfg, font_range);
   else
-    io.Fonts->AddFontFromMemoryCompressedTTF(unifont_compressed_data, unifont_compressed_size, 0, &cfg, font_range);
+    addRomfsFont(atlas, unifont, 0, &cfg, font_range);
 
   cfg.MergeMode = true;
 
   static ImWchar fa_range[] = {ICON_MIN_FA, ICON_MAX_FA, 0};
-  io.Fonts->AddFontFromMemoryCompressedTTF(fa_compressed_data, fa_compressed_size, iconSize, &cfg, fa_range);
-  io.Fonts->AddFontFromMemoryCompressedTTF(cascadia_compressed_data, cascadia_compressed_size, fontSize);
+  addRomfsFont(atlas, fa, iconSize, &cfg, fa_range);
+  addRomfsFont(atlas, cascadia, fontSize, nullptr, nullptr);
 
-  io.Fonts->Build();
+  atlas->Build();
+  if (save) cache.save(atlas);
 }
 
 void Player::shutdown() { mpv->command(config->Data.Mpv.WatchLater ? "quit-watch-later" : "quit"); }
@@ -372,6 +606,9 @@ void Player::initObservers() {
   mpv->observeEvent(MPV_EVENT_SHUTDOWN, [this](void *data) { SetWindowShouldClose(true); });
 
   mpv->observeEvent(MPV_EVENT_VIDEO_RECONFIG, [this](void *data) {
+    auto dw = mpv->property<int64_t, MPV_FORMAT_INT64>("dwidth");
+    auto dh = mpv->property<int64_t, MPV_FORMAT_INT64>("dheight");
+    videoAspect = dw > 0 && dh > 0 ? (double)dw / dh : 0;
     if (!mpv->fullscreen) updateWindowState();
   });
 
@@ -380,6 +617,22 @@ void Player::initObservers() {
     if (path != "" && path != "bd://" && path != "dvd://") config->addRecentFile(path, mpv->property("media-title"));
     mpv->property("force-media-title", "");
     mpv->property("start", "none");
+
+    // long local videos get a keyframe index, short ones seek fast enough without
+    if (path.find("://") == std::string::npos && mpv->property("vid") != "no" &&
+        mpv->property<double, MPV_FORMAT_DOUBLE>("duration") >= 600)
+      keyframes->open(path);
+    else
+      keyframes->close();
+    if (config->Data.Interface.Waveform && path.find("://") == std::string::npos && mpv->property("aid") != "no")
+      waveform->open(path);
+    else
+      waveform->close();
+    if (config->Data.Interface.Scenes && path.find("://") == std::string::npos && mpv->property("vid") != "no")
+      scenes->open(path);
+    else
+      scenes->close();
+    applyLoudness();
   });
 
   mpv->observeEvent(MPV_EVENT_CLIENT_MESSAGE, [this](void *data) {
@@ -395,7 +648,23 @@ void Player::initObservers() {
     }
   });
 
-  mpv->observeProperty<char *, MPV_FORMAT_STRING>("media-title", [this](char *data) { SetWindowTitle(data); });
+  mpv->observeProperty<char *, MPV_FORMAT_STRING>("media-title", [this](char *data) {
+    SetWindowTitle(data);
+    config->addGlyphs(data);
+  });
+  mpv->observeProperty<mpv_node, MPV_FORMAT_NODE>("playlist", [this](mpv_node node) {
+    for (auto &item : mpv->playlist) {
+      config->addGlyphs(item.title);
+      config->addGlyphs(item.filename());
+    }
+    requestLoudness();
+  });
+  mpv->observeProperty<mpv_node, MPV_FORMAT_NODE>("chapter-list", [this](mpv_node node) {
+    for (auto &chapter : mpv->chapters) config->addGlyphs(chapter.title);
+  });
+  mpv->observeProperty<mpv_node, MPV_FORMAT_NODE>("track-list", [this](mpv_node node) {
+    for (auto &track : mpv->tracks) config->addGlyphs(track.title);
+  });
   mpv->observeProperty<int, MPV_FORMAT_FLAG>("border", [this](int flag) { SetWindowDecorated(flag); });
   mpv->observeProperty<int, MPV_FORMAT_FLAG>("ontop", [this](int flag) { SetWindowFloating(flag); });
   mpv->observeProperty<int, MPV_FORMAT_FLAG>("window-maximized", [this](int flag) { SetWindowMaximized(flag); });
@@ -408,6 +677,59 @@ void Player::initObservers() {
   mpv->observeProperty<int, MPV_FORMAT_FLAG>("fullscreen", [this](int flag) { SetWindowFullscreen(flag); });
 }
 
+// state is published from the observers on the main thread, commands run on the server thread
+void Player::initControl() {
+  auto address = config->controlAddress();
+  controlServer = new ControlServer(address, config->controlToken(), [this](const std::vector<std::string> &args) {
+    return std::string(mpv_error_string(mpv->commandSync(args)));
+  });
+  if (!controlServer->start()) {
+    fmt::print(fg(fmt::color::yellow), "Failed to listen on {}\n", address);
+    delete controlServer;
+    controlServer = nullptr;
+    return;
+  }
+
+  mpv->observeProperty<mpv_node, MPV_FORMAT_NODE>("playlist", [this](mpv_node node) {
+    auto list = nlohmann::json::array();
+    for (auto &item : mpv->playlist)
+      list.push_back({{"id", item.id}, {"title", item.title}, {"path", item.path.string()}});
+    controlServer->publish("playlist", list);
+  });
+  mpv->observeProperty<mpv_node, MPV_FORMAT_NODE>("track-list", [this](mpv_node node) {
+    auto list = nlohmann::json::array();
+    for (auto &track : mpv->tracks)
+      list.push_back({{"id", track.id},
+                      {"type", track.type},
+                      {"title", track.title},
+                      {"lang", track.lang},
+                      {"selected", track.selected}});
+    controlServer->publish("tracks", list);
+  });
+  mpv->observeProperty<mpv_node, MPV_FORMAT_NODE>("chapter-list", [this](mpv_node node) {
+    auto list = nlohmann::json::array();
+    for (auto &chapter : mpv->chapters)
+      list.push_back({{"id", chapter.id}, {"title", chapter.title}, {"time", chapter.time}});
+    controlServer->publish("chapters", list);
+  });
+  mpv->observeProperty<int64_t, MPV_FORMAT_INT64>("playlist-pos",
+                                                  [this](int64_t val) { controlServer->publish("playlist-pos", val); });
+  mpv->observeProperty<int64_t, MPV_FORMAT_INT64>("chapter",
+                                                  [this](int64_t val) { controlServer->publish("chapter", val); });
+  mpv->observeProperty<int64_t, MPV_FORMAT_INT64>("volume",
+                                                  [this](int64_t val) { controlServer->publish("volume", val); });
+  mpv->observeProperty<double, MPV_FORMAT_DOUBLE>("time-pos",
+                                                  [this](double val) { controlServer->publish("position", val); });
+  mpv->observeProperty<double, MPV_FORMAT_DOUBLE>("duration",
+                                                  [this](double val) { controlServer->publish("duration", val); });
+  mpv->observeProperty<int, MPV_FORMAT_FLAG>("pause", [this](int flag) { controlServer->publish("pause", flag != 0); });
+  mpv->observeProperty<int, MPV_FORMAT_FLAG>("mute", [this](int flag) { controlServer->publish("mute", flag != 0); });
+  mpv->observeProperty<int, MPV_FORMAT_FLAG>("idle-active",
+                                             [this](int flag) { controlServer->publish("idle", flag != 0); });
+  mpv->observeProperty<char *, MPV_FORMAT_STRING>("media-title",
+                                                  [this](char *data) { controlServer->publish("media-title", data); });
+}
+
 void Player::writeMpvConf() {
   auto path = dataPath();
   auto mpvConf = path / "mpv.conf";
@@ -487,9 +809,65 @@ void Player::execute(int n_args, const char **args_) {
            }
          }
        }},
+      {"video-wall",
+       [&](int n, const char **args) {
+         if (n == 0 && videoWall->active()) return closeWall();
+         std::vector<std::string> paths(args, args + n);
+         if (paths.empty())
+           for (auto &item : mpv->playlist) paths.push_back(item.path.string());
+         if (!paths.empty()) openWall(paths);
+       }},
+      {"compare",
+       [&](int n, const char **args) {
+         if (n == 0 && compare->active()) return closeCompare();
+         if (n > 0)
+           openCompare(args[0]);
+         else if (auto res = NFD::openFile(mediaFilters))
+           openCompare(res->string());
+       }},
+      {"compare-layout", [&](int n, const char **args) { compare->cycleLayout(); }},
+      {"mirror", [&](int n, const char **args) { SetMirror(!GetMirror()); }},
+      {"thumb",
+       [&](int n, const char **args) {
+         if (n >= 4) seekPreview->show(atof(args[0]), (float)atof(args[1]), (float)atof(args[2]), (float)atof(args[3]));
+       }},
+      {"thumb-clear", [&](int n, const char **args) { seekPreview->hide(); }},
+      {"seekbar",
+       [&](int n, const char **args) {
+         if (n < 4) return;
+         waveform->show((float)atof(args[0]), (float)atof(args[1]), (float)atof(args[2]), (float)atof(args[3]));
+       }},
+      {"seekbar-clear", [&](int n, const char **args) { waveform->hide(); }},
+      {"seekbar-drag",
+       [&](int n, const char **args) {
+         if (n < 2) return;
+         double duration = mpv->property<double, MPV_FORMAT_DOUBLE>("duration");
+         // a known keyframe needs neither a search for it nor decoding up to the target
+         if (strcmp(args[1], "exact") != 0 && keyframes->ready() && duration > 0) {
+           double time = keyframes->snap(atof(args[0]) * duration / 100);
+           mpv->commandv("seek", fmt::format("{:.6f}", time).c_str(), "absolute+keyframes", nullptr);
+         } else {
+           auto flags = strcmp(args[1], "exact") == 0 ? "absolute-percent+exact" : "absolute-percent+keyframes";
+           mpv->commandv("seek", args[0], flags, nullptr);
+         }
+       }},
+      {"next-scene",
+       [&](int n, const char **args) {
+         double time = scenes->after(mpv->property<double, MPV_FORMAT_DOUBLE>("time-pos") + 0.1);
+         if (time >= 0) mpv->commandv("seek", fmt::format("{:.6f}", time).c_str(), "absolute+exact", nullptr);
+       }},
+      {"prev-scene",
+       [&](int n, const char **args) {
+         if (!scenes->ready()) return;
+         // a little back from the current position, or it would land on the cut just jumped to
+         double pos = mpv->property<double, MPV_FORMAT_DOUBLE>("time-pos") - 0.5, time = scenes->before(pos);
+         if (time > pos) time = 0;
+         mpv->commandv("seek", fmt::format("{:.6f}", time).c_str(), "absolute+exact", nullptr);
+       }},
       {"about", [&](int n, const char **args) { about->show(); }},
       {"settings", [&](int n, const char **args) { settings->show(); }},
       {"metrics", [&](int n, const char **args) { debug->show(); }},
+      {"log-viewer", [&](int n, const char **args) { logViewer->show(n, args); }},
       {"command-palette", [&](int n, const char **args) { commandPalette->show(n, args); }},
       {"context-menu", [&](int n, const char **args) { contextMenu->show(); }},
       {"show-message",
@@ -500,6 +878,13 @@ void Player::execute(int n_args, const char **args_) {
        [&](int n, const char **args) {
          if (n > 0) ImGui::SetTheme(args[0], nullptr, config->Data.Interface.Rounding, config->Data.Interface.Shadow);
        }},
+      {"loudness-update",
+       [&](int n, const char **args) {
+         // with a path, that file was measured; without, the setting changed
+         if (n > 0 && mpv->property("path") != args[0]) return;
+         if (n == 0) requestLoudness();
+         applyLoudness();
+       }},
   };
 
   const char *cmd = args_[0];
@@ -529,6 +914,33 @@ void Player::openFolderDlg(bool append, bool disk) {
   mpv->command("set pause no");
 }
 
+void Player::openWall(std::vector<std::string> paths) {
+  closeWall();
+  mpv->command("set pause yes");
+  videoWall->open(paths);
+  ContextGuard guard(this);
+  videoWall->initRender(GetGLAddrFunc());
+}
+
+void Player::closeWall() {
+  if (!videoWall->active()) return;
+  ContextGuard guard(this);
+  videoWall->close();
+}
+
+void Player::openCompare(std::string path) {
+  closeCompare();
+  compare->open(path);
+  ContextGuard guard(this);
+  compare->initRender(GetGLAddrFunc());
+}
+
+void Player::closeCompare() {
+  if (!compare->active()) return;
+  ContextGuard guard(this);
+  compare->close();
+}
+
 void Player::openClipboard() {
   auto content = GetClipboardString();
   if (content != "") {
@@ -581,40 +993,90 @@ void Player::playlistSort(bool reverse) {
 }
 
 void Player::load(std::vector<std::filesystem::path> files, bool append, bool disk) {
-  int i = 0;
+  std::vector<std::function<void()>> after;
+  loadList(expand(files, after, append, disk), append ? "append" : "replace");
+  for (auto &open : after) open();
+}
+
+// Folders are expanded to the media files in them, for one loadlist. Subtitles and discs are opened by after
+// once that is loaded, in the order given, so a disc still plays after the files before it.
+std::vector<std::string> Player::expand(std::vector<std::filesystem::path> files,
+                                        std::vector<std::function<void()>> &after, bool append, bool disk) {
+  std::vector<std::string> items;
   for (auto &file : files) {
     if (std::filesystem::is_directory(file)) {
       if (disk) {
         if (std::filesystem::exists(file / u8"BDMV"))
-          openBluray(file);
+          after.push_back([this, file]() { openBluray(file); });
         else
-          openDvd(file);
+          after.push_back([this, file]() { openDvd(file); });
         break;
       }
       for (const auto &entry : std::filesystem::recursive_directory_iterator(file)) {
         auto path = entry.path().string();
-        if (isMediaFile(path)) {
-          const char *action = append ? "append" : (i > 0 ? "append-play" : "replace");
-          mpv->commandv("loadfile", path.c_str(), action, nullptr);
-          i++;
-        }
+        if (isMediaFile(path)) items.push_back(path);
       }
     } else {
       if (file.extension() == ".iso") {
         if ((double)std::filesystem::file_size(file) / 1000 / 1000 / 1000 > 4.7)
-          openBluray(file);
+          after.push_back([this, file]() { openBluray(file); });
         else
-          openDvd(file);
+          after.push_back([this, file]() { openDvd(file); });
         break;
       } else if (isSubtitleFile(file.string())) {
-        mpv->commandv("sub-add", file.string().c_str(), append ? "auto" : "select", nullptr);
+        after.push_back([this, file, append]() {
+          mpv->commandv("sub-add", file.string().c_str(), append ? "auto" : "select", nullptr);
+        });
       } else {
-        const char *action = append ? "append" : (i > 0 ? "append-play" : "replace");
-        mpv->commandv("loadfile", file.string().c_str(), action, nullptr);
+        items.push_back(file.string());
       }
-      i++;
     }
   }
+  return items;
+}
+
+// One loadlist instead of a loadfile per item, so the playlist is only rebuilt once. It runs synchronously
+// and the playlist is counted around it under the lock, so concurrent loads report their own entries.
+std::pair<int64_t, int64_t> Player::loadList(const std::vector<std::string> &items, const char *action) {
+  if (items.empty()) return {-1, 0};
+  std::vector<std::string> playlist = {"#EXTM3U"};
+  playlist.insert(playlist.end(), items.begin(), items.end());
+
+  std::lock_guard<std::mutex> lock(loadLock);
+  int64_t before = strcmp(action, "replace") == 0 ? 0 : mpv->property<int64_t, MPV_FORMAT_INT64>("playlist-count");
+  if (mpv->commandSync({"loadlist", fmt::format("memory://{}", join(playlist, "\n")), action}) < 0) return {-1, 0};
+  int64_t after = mpv->property<int64_t, MPV_FORMAT_INT64>("playlist-count");
+  return {before, after - before};
+}
+
+// Requests from other instances, in the style of mpv's JSON IPC:
+//   {"command": "open", "paths": [...], "request_id": 1}
+//   {"request_id": 1, "error": "success", "data": {"first": 12, "count": 2000}}
+std::string Player::handleIpc(const std::string &request) {
+  nlohmann::json reply = {{"error", "success"}};
+  auto req = nlohmann::json::parse(request, nullptr, false);
+  if (req.is_discarded() || !req.is_object()) {
+    reply["error"] = "invalid request";
+    return reply.dump();
+  }
+  if (req.contains("request_id")) reply["request_id"] = req["request_id"];
+
+  if (req.value("command", "") == "open" && req["paths"].is_array()) {
+    std::vector<std::filesystem::path> paths;
+    for (auto &path : req["paths"])
+      if (path.is_string()) paths.push_back(std::filesystem::u8path(path.get<std::string>()));
+    try {
+      std::vector<std::function<void()>> after;
+      auto [first, count] = loadList(expand(paths, after, true), "append-play");
+      for (auto &open : after) open();
+      reply["data"] = {{"first", first}, {"count", count}};
+    } catch (const std::exception &e) {
+      reply["error"] = e.what();
+    }
+  } else {
+    reply["error"] = "unknown command";
+  }
+  return reply.dump();
 }
 
 void Player::drawOpenURL() {
@@ -675,6 +1137,33 @@ void Player::messageBox(std::string title, std::string msg) {
   m_dialog = true;
 }
 
+void Player::requestLoudness() {
+  if (!config->Data.Mpv.Loudness) return;
+  // from the playing file on, wrapping around
+  std::vector<std::string> paths;
+  size_t count = mpv->playlist.size(), start = (size_t)std::max<int64_t>(mpv->playlistPlayingPos, 0);
+  for (size_t i = 0; i < count; i++) {
+    auto path = mpv->playlist[(start + i) % count].path.string();
+    if (path.find("://") == std::string::npos) paths.push_back(path);
+  }
+  loudness->request(paths);
+}
+
+// scanned files play at the reference loudness, as far as their peak allows, the rest at unity gain
+void Player::applyLoudness() {
+  auto path = mpv->property("path");
+  std::optional<LoudnessScanner::Result> level;
+  if (config->Data.Mpv.Loudness && path.find("://") == std::string::npos) level = loudness->lookup(path);
+  double gain = 0;
+  if (level) gain = std::round(std::min(LoudnessScanner::Reference - level->integrated, -level->peak) * 100) / 100;
+  if (gain == loudnessGain) return;
+
+  if (loudnessGain != 0) mpv->command("no-osd af remove @loudness");
+  if (gain != 0)
+    mpv->commandv("af", "add", fmt::format("@loudness:lavfi-volume=volume={:.2f}dB", gain).c_str(), nullptr);
+  loudnessGain = gain;
+}
+
 bool Player::isMediaFile(std::string file) {
   auto ext = std::filesystem::path(file).extension().string();
   if (ext.empty()) return false;
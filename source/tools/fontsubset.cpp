@@ -0,0 +1,467 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <regex>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <imgui.h>
+#include <imgui_internal.h>
+#include <fonts/cascadia.h>
+#include <fonts/fontawesome.h>
+#include <fonts/unifont.h>
+
+// Subsets the fonts embedded in the imgui library to the codepoints the UI uses, so the
+// binary bundles them uncompressed and the atlas only holds what can be shown.
+// Usage: fontsubset <font> <output> [--icons <fontawesome.h>] <input>...
+//   Without --icons, every character of the inputs is kept (the language files).
+//   With --icons, the ICON_FA_* macros referenced by the inputs are kept (the sources).
+// A <output>.ranges file lists the requested codepoints as little endian u32 pairs, the
+// subset has every one of them the full font has.
+
+namespace {
+using Codepoints = std::set<uint32_t>;
+
+uint16_t u16(const std::string &d, size_t o) { return (uint8_t)d[o] << 8 | (uint8_t)d[o + 1]; }
+uint32_t u32(const std::string &d, size_t o) { return (uint32_t)u16(d, o) << 16 | u16(d, o + 2); }
+void put16(std::string &d, size_t o, uint16_t v) {
+  d[o] = (char)(v >> 8);
+  d[o + 1] = (char)v;
+}
+void put32(std::string &d, size_t o, uint32_t v) {
+  put16(d, o, v >> 16);
+  put16(d, o + 2, v & 0xffff);
+}
+void append16(std::string &d, uint16_t v) { d.append({(char)(v >> 8), (char)v}); }
+void append32(std::string &d, uint32_t v) {
+  append16(d, v >> 16);
+  append16(d, v & 0xffff);
+}
+
+uint32_t checksum(const std::string &d) {
+  uint32_t sum = 0;
+  std::string p = d;
+  p.resize((p.size() + 3) & ~3);
+  for (size_t i = 0; i < p.size(); i += 4) sum += u32(p, i);
+  return sum;
+}
+
+uint32_t tag(const char *s) { return (uint32_t)s[0] << 24 | s[1] << 16 | s[2] << 8 | s[3]; }
+
+// tables ImGui never reads, or that refer to glyph ids which are renumbered
+const std::set<uint32_t> dropTables = {
+    tag("GSUB"), tag("GPOS"), tag("GDEF"), tag("BASE"), tag("JSTF"), tag("MATH"), tag("kern"), tag("DSIG"),
+    tag("hdmx"), tag("LTSH"), tag("VDMX"), tag("vhea"), tag("vmtx"), tag("STAT"), tag("meta"), tag("FFTM"),
+};
+
+class Font {
+ public:
+  explicit Font(std::string data) : data(std::move(data)) {
+    uint16_t numTables = u16(this->data, 4);
+    for (int i = 0; i < numTables; i++) {
+      size_t rec = 12 + i * 16;
+      tables[u32(this->data, rec)] = this->data.substr(u32(this->data, rec + 8), u32(this->data, rec + 12));
+    }
+  }
+
+  bool has(const char *name) const { return tables.contains(tag(name)); }
+  std::string &table(const char *name) {
+    auto it = tables.find(tag(name));
+    if (it == tables.end()) throw std::runtime_error(std::string("missing table ") + name);
+    return it->second;
+  }
+
+  // unicode cmap (format 4 or 12) as codepoint -> glyph
+  std::map<uint32_t, uint16_t> readCmap() {
+    auto &cmap = table("cmap");
+    std::map<uint32_t, uint16_t> map;
+    uint16_t n = u16(cmap, 2);
+    size_t best = 0;
+    for (int i = 0; i < n; i++) {
+      size_t rec = 4 + i * 8;
+      uint16_t platform = u16(cmap, rec), encoding = u16(cmap, rec + 2);
+      size_t offset = u32(cmap, rec + 4);
+      uint16_t format = u16(cmap, offset);
+      bool unicode = platform == 0 || (platform == 3 && (encoding == 1 || encoding == 10));
+      if (!unicode || (format != 4 && format != 12)) continue;
+      if (best == 0 || format == 12) best = offset;
+    }
+    if (best == 0) throw std::runtime_error("no unicode cmap");
+
+    if (u16(cmap, best) == 12) {
+      uint32_t groups = u32(cmap, best + 12);
+      for (uint32_t i = 0; i < groups; i++) {
+        size_t g = best + 16 + i * 12;
+        uint32_t start = u32(cmap, g), end = u32(cmap, g + 4), glyph = u32(cmap, g + 8);
+        for (uint32_t c = start; c <= end; c++) map[c] = (uint16_t)(glyph + c - start);
+      }
+    } else {
+      uint16_t segs = u16(cmap, best + 6) / 2;
+      size_t ends = best + 14, starts = ends + segs * 2 + 2, deltas = starts + segs * 2, ranges = deltas + segs * 2;
+      for (int i = 0; i < segs; i++) {
+        uint16_t start = u16(cmap, starts + i * 2), end = u16(cmap, ends + i * 2);
+        uint16_t delta = u16(cmap, deltas + i * 2), rangeOffset = u16(cmap, ranges + i * 2);
+        for (uint32_t c = start; c <= end && c != 0xffff; c++) {
+          uint16_t glyph;
+          if (rangeOffset == 0) {
+            glyph = (uint16_t)(c + delta);
+          } else {
+            glyph = u16(cmap, ranges + i * 2 + rangeOffset + (c - start) * 2);
+            if (glyph != 0) glyph = (uint16_t)(glyph + delta);
+          }
+          if (glyph != 0) map[c] = glyph;
+        }
+      }
+    }
+    return map;
+  }
+
+  std::string write() {
+    for (auto t : dropTables) tables.erase(t);
+    std::string out;
+    uint16_t n = (uint16_t)tables.size();
+    uint16_t entrySelector = 0;
+    while ((2 << entrySelector) <= n) entrySelector++;
+    uint16_t searchRange = (1 << entrySelector) * 16;
+    append32(out, u32(data, 0));
+    append16(out, n);
+    append16(out, searchRange);
+    append16(out, entrySelector);
+    append16(out, n * 16 - searchRange);
+
+    auto &head = table("head");
+    put32(head, 8, 0);
+    size_t headOffset = 0;
+    std::string body;
+    for (auto &[t, d] : tables) {
+      size_t offset = 12 + n * 16 + body.size();
+      if (t == tag("head")) headOffset = offset;
+      append32(out, t);
+      append32(out, checksum(d));
+      append32(out, (uint32_t)offset);
+      append32(out, (uint32_t)d.size());
+      body += d;
+      body.resize((body.size() + 3) & ~3);
+    }
+    out += body;
+    put32(out, headOffset + 8, 0xB1B0AFBA - checksum(out));
+    return out;
+  }
+
+  std::string data;
+  std::map<uint32_t, std::string> tables;
+};
+
+// a single format 12 subtable, for both the unicode and the windows platform
+void writeCmap(Font &font, const std::map<uint32_t, uint16_t> &cmap) {
+  std::vector<std::tuple<uint32_t, uint32_t, uint16_t>> groups;
+  for (auto [c, g] : cmap) {
+    if (!groups.empty()) {
+      auto &[start, end, glyph] = groups.back();
+      if (c == end + 1 && g == glyph + (c - start)) {
+        end = c;
+        continue;
+      }
+    }
+    groups.emplace_back(c, c, g);
+  }
+  std::string out;
+  append16(out, 0);
+  append16(out, 2);
+  for (uint16_t platform : {0, 3}) {
+    append16(out, platform);
+    append16(out, platform == 0 ? 4 : 10);
+    append32(out, 20);
+  }
+  append16(out, 12);
+  append16(out, 0);
+  append32(out, 16 + (uint32_t)groups.size() * 12);
+  append32(out, 0);
+  append32(out, (uint32_t)groups.size());
+  for (auto &[start, end, glyph] : groups) {
+    append32(out, start);
+    append32(out, end);
+    append32(out, glyph);
+  }
+  font.table("cmap") = out;
+}
+
+// The kept glyphs are renumbered, so the TrueType outline tables shrink with them.
+void subsetGlyf(Font &font, const std::map<uint32_t, uint16_t> &cmap, const Codepoints &keep) {
+  auto &head = font.table("head");
+  auto &maxp = font.table("maxp");
+  auto &hhea = font.table("hhea");
+  auto &hmtx = font.table("hmtx");
+  auto &loca = font.table("loca");
+  auto &glyf = font.table("glyf");
+  bool longLoca = u16(head, 50) == 1;
+  uint16_t numGlyphs = u16(maxp, 4);
+  uint16_t numMetrics = u16(hhea, 34);
+  auto glyphAt = [&](uint16_t id) {
+    size_t start = longLoca ? u32(loca, id * 4) : u16(loca, id * 2) * 2;
+    size_t end = longLoca ? u32(loca, id * 4 + 4) : u16(loca, id * 2 + 2) * 2;
+    return glyf.substr(start, end - start);
+  };
+
+  // glyph 0 is .notdef, composite glyphs pull in their components
+  std::set<uint16_t> glyphs = {0};
+  for (auto c : keep)
+    if (auto it = cmap.find(c); it != cmap.end()) glyphs.insert(it->second);
+  std::vector<uint16_t> pending(glyphs.begin(), glyphs.end());
+  while (!pending.empty()) {
+    uint16_t id = pending.back();
+    pending.pop_back();
+    auto g = glyphAt(id);
+    if (g.size() < 10 || (int16_t)u16(g, 0) >= 0) continue;
+    for (size_t o = 10;;) {
+      uint16_t flags = u16(g, o), component = u16(g, o + 2);
+      if (component < numGlyphs && glyphs.insert(component).second) pending.push_back(component);
+      o += 4 + ((flags & 0x1) ? 4 : 2) + ((flags & 0x8) ? 2 : (flags & 0x40) ? 4 : (flags & 0x80) ? 8 : 0);
+      if (!(flags & 0x20)) break;
+    }
+  }
+
+  std::map<uint16_t, uint16_t> ids;
+  for (auto id : glyphs) ids[id] = (uint16_t)ids.size();
+
+  std::string newGlyf, newLoca, newHmtx;
+  for (auto id : glyphs) {
+    append32(newLoca, (uint32_t)newGlyf.size());
+    auto g = glyphAt(id);
+    if (g.size() >= 10 && (int16_t)u16(g, 0) < 0) {
+      for (size_t o = 10;;) {
+        uint16_t flags = u16(g, o);
+        put16(g, o + 2, ids[u16(g, o + 2)]);
+        o += 4 + ((flags & 0x1) ? 4 : 2) + ((flags & 0x8) ? 2 : (flags & 0x40) ? 4 : (flags & 0x80) ? 8 : 0);
+        if (!(flags & 0x20)) break;
+      }
+    }
+    newGlyf += g;
+    newGlyf.resize((newGlyf.size() + 3) & ~3);
+
+    uint16_t m = std::min<uint16_t>(id, numMetrics - 1);
+    append16(newHmtx, u16(hmtx, m * 4));
+    size_t lsb = id < numMetrics ? id * 4 + 2 : numMetrics * 4 + (id - numMetrics) * 2;
+    append16(newHmtx, u16(hmtx, lsb));
+  }
+  append32(newLoca, (uint32_t)newGlyf.size());
+
+  glyf = newGlyf;
+  loca = newLoca;
+  hmtx = newHmtx;
+  put16(head, 50, 1);
+  put16(maxp, 4, (uint16_t)glyphs.size());
+  put16(hhea, 34, (uint16_t)glyphs.size());
+
+  // glyph names refer to the old ids
+  auto &post = font.table("post");
+  if (post.size() >= 32) {
+    post.resize(32);
+    put32(post, 0, 0x00030000);
+  }
+
+  std::map<uint32_t, uint16_t> newCmap;
+  for (auto c : keep)
+    if (auto it = cmap.find(c); it != cmap.end()) newCmap[c] = ids[it->second];
+  writeCmap(font, newCmap);
+}
+
+// CFF outlines keep their glyph ids, unused charstrings are replaced with a bare endchar.
+// Only fonts with 5 byte offsets in the top dict (as font tools write them) are handled.
+bool subsetCff(Font &font, const std::set<uint16_t> &glyphs) {
+  auto &cff = font.table("CFF ");
+  // INDEX: count, offset size, offsets (1-based), data
+  auto indexEnd = [&](size_t p) -> size_t {
+    uint16_t count = u16(cff, p);
+    if (count == 0) return p + 2;
+    uint8_t offSize = cff[p + 2];
+    size_t last = 0;
+    for (int i = 0; i < offSize; i++) last = last << 8 | (uint8_t)cff[p + 3 + count * offSize + i];
+    return p + 3 + (count + 1) * offSize + last - 1;
+  };
+  size_t top = indexEnd(cff[2]);
+  if (u16(cff, top) != 1) return false;
+  uint8_t offSize = cff[top + 2];
+  size_t dict = top + 3 + 2 * offSize, dictEnd = indexEnd(top);
+
+  // operator -> position of its 5 byte operand (the last one, e.g. the offset of Private)
+  std::map<int, size_t> offsets;
+  size_t lastInt = 0;
+  for (size_t p = dict; p < dictEnd;) {
+    uint8_t b = cff[p];
+    if (b == 28) {
+      p += 3, lastInt = 0;
+    } else if (b == 29) {
+      lastInt = p + 1, p += 5;
+    } else if (b == 30) {
+      do p++;
+      while (p < dictEnd && ((uint8_t)cff[p] & 0x0f) != 0x0f && ((uint8_t)cff[p] & 0xf0) != 0xf0);
+      p++, lastInt = 0;
+    } else if (b >= 32 && b <= 246) {
+      p++, lastInt = 0;
+    } else if (b >= 247 && b <= 254) {
+      p += 2, lastInt = 0;
+    } else {
+      int op = b == 12 ? 1200 + (uint8_t)cff[p + 1] : b;
+      p += b == 12 ? 2 : 1;
+      if (lastInt != 0) offsets[op] = lastInt;
+      if (op == 1230) return false;  // CID-keyed
+    }
+  }
+  if (!offsets.contains(17)) return false;
+
+  size_t charStrings = u32(cff, offsets[17]);
+  uint16_t count = u16(cff, charStrings);
+  uint8_t csOffSize = cff[charStrings + 2];
+  auto csOffset = [&](int i) {
+    size_t v = 0;
+    for (int k = 0; k < csOffSize; k++) v = v << 8 | (uint8_t)cff[charStrings + 3 + i * csOffSize + k];
+    return v;
+  };
+  size_t csData = charStrings + 3 + (count + 1) * csOffSize - 1;
+  std::string data;
+  std::vector<uint32_t> ends;
+  for (int i = 0; i < count; i++) {
+    if (glyphs.contains((uint16_t)i))
+      data += cff.substr(csData + csOffset(i), csOffset(i + 1) - csOffset(i));
+    else
+      data += '\x0e';
+    ends.push_back((uint32_t)data.size() + 1);
+  }
+  std::string index;
+  append16(index, count);
+  index += (char)4;
+  append32(index, 1);
+  for (auto e : ends) append32(index, e);
+  index += data;
+
+  size_t oldEnd = indexEnd(charStrings);
+  int64_t delta = (int64_t)index.size() - (int64_t)(oldEnd - charStrings);
+  for (auto [op, pos] : offsets) {
+    uint32_t v = u32(cff, pos);
+    if (v > charStrings && !(op == 16 && v <= 1)) put32(cff, pos, (uint32_t)(v + delta));
+  }
+  cff = cff.substr(0, charStrings) + index + cff.substr(oldEnd);
+  return true;
+}
+
+void addText(Codepoints &cps, const std::string &text) {
+  const char *p = text.c_str(), *end = p + text.size();
+  while (p < end) {
+    unsigned int c;
+    p += ImTextCharFromUtf8(&c, p, end);
+    if (c >= 0x20) cps.insert(c);
+  }
+}
+
+std::string readFile(const std::filesystem::path &path) {
+  std::ifstream f(path, std::ios::binary);
+  if (!f) throw std::runtime_error("failed to read " + path.string());
+  return std::string(std::istreambuf_iterator<char>(f), {});
+}
+
+void writeFile(const std::filesystem::path &path, const std::string &data) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out.write(data.data(), data.size())) throw std::runtime_error("failed to write " + path.string());
+}
+
+// the decompressed TTF, taken from an atlas that is never built
+std::string decompress(const unsigned int *data, unsigned int size) {
+  ImFontAtlas atlas;
+  ImFontConfig cfg;
+  cfg.SizePixels = 13;
+  atlas.AddFontFromMemoryCompressedTTF(data, (int)size, 0, &cfg);
+  auto &font = atlas.ConfigData.back();
+  return std::string((const char *)font.FontData, font.FontDataSize);
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s <unifont|fontawesome|cascadia> <output> [--icons <fontawesome.h>] <input>...\n",
+            argv[0]);
+    return 1;
+  }
+  std::string name = argv[1];
+  std::filesystem::path outPath = argv[2];
+
+  try {
+    std::string ttf;
+    Codepoints keep;
+    // the default ImGui range, the fallback and ellipsis characters
+    if (name != "fontawesome") {
+      for (uint32_t c = 0x20; c <= 0xff; c++) keep.insert(c);
+      keep.insert({0x2026, 0xfffd});
+    }
+    if (name == "unifont")
+      ttf = decompress(unifont_compressed_data, unifont_compressed_size);
+    else if (name == "fontawesome")
+      ttf = decompress(fa_compressed_data, fa_compressed_size);
+    else if (name == "cascadia")
+      ttf = decompress(cascadia_compressed_data, cascadia_compressed_size);
+    else
+      throw std::runtime_error("unknown font: " + name);
+
+    std::map<std::string, uint32_t> icons;
+    for (int i = 3; i < argc; i++) {
+      if (strcmp(argv[i], "--icons") == 0 && i + 1 < argc) {
+        static const std::regex define(R"(#define (ICON_FA_\w+) .*// U\+([0-9a-fA-F]+))");
+        auto header = readFile(argv[++i]);
+        for (std::sregex_iterator it(header.begin(), header.end(), define), end; it != end; ++it)
+          icons[(*it)[1]] = (uint32_t)std::stoul((*it)[2], nullptr, 16);
+        continue;
+      }
+      auto text = readFile(argv[i]);
+      if (icons.empty()) {
+        addText(keep, text);
+        continue;
+      }
+      static const std::regex use(R"(ICON_FA_\w+)");
+      for (std::sregex_iterator it(text.begin(), text.end(), use), end; it != end; ++it)
+        if (auto icon = icons.find(it->str()); icon != icons.end()) keep.insert(icon->second);
+    }
+
+    Font font(ttf);
+    auto cmap = font.readCmap();
+    if (font.has("glyf")) {
+      subsetGlyf(font, cmap, keep);
+    } else {
+      std::map<uint32_t, uint16_t> kept;
+      std::set<uint16_t> glyphs = {0};
+      for (auto c : keep) {
+        if (auto it = cmap.find(c); it != cmap.end()) {
+          kept[c] = it->second;
+          glyphs.insert(it->second);
+        }
+      }
+      if (!font.has("CFF ") || !subsetCff(font, glyphs))
+        fprintf(stderr, "fontsubset: %s outlines kept as is\n", name.c_str());
+      writeCmap(font, kept);
+    }
+
+    std::filesystem::create_directories(outPath.parent_path());
+    writeFile(outPath, font.write());
+
+    std::string ranges;
+    for (auto it = keep.begin(); it != keep.end();) {
+      uint32_t start = *it, end = start;
+      while (++it != keep.end() && *it == end + 1) end = *it;
+      for (uint32_t v : {start, end})
+        for (int i = 0; i < 4; i++) ranges.push_back((char)(v >> (i * 8)));
+    }
+    auto rangesPath = outPath;
+    writeFile(rangesPath.replace_extension(".ranges"), ranges);
+  } catch (const std::exception &e) {
+    fprintf(stderr, "fontsubset: %s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
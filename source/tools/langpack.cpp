@@ -0,0 +1,37 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include "helpers/lang_pack.h"
+
+// Converts JSON language files to the binary packs bundled with romfs.
+// Usage: langpack <output dir> <lang.json>...
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <output dir> <lang.json>...\n", argv[0]);
+    return 1;
+  }
+  std::filesystem::path outDir = argv[1];
+  std::filesystem::create_directories(outDir);
+  for (int i = 2; i < argc; i++) {
+    std::filesystem::path path = argv[i];
+    std::ifstream f(path, std::ios::binary);
+    std::string json(std::istreambuf_iterator<char>(f), {});
+    ImPlay::LangData lang;
+    if (!ImPlay::LangPack::parseJson(json, lang)) {
+      fprintf(stderr, "langpack: invalid language file: %s\n", path.string().c_str());
+      return 1;
+    }
+    auto outPath = outDir / path.filename().replace_extension(".bin");
+    std::ofstream out(outPath, std::ios::binary | std::ios::trunc);
+    out << ImPlay::LangPack::write(lang);
+    if (!out) {
+      fprintf(stderr, "langpack: failed to write %s\n", outPath.string().c_str());
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -3,6 +3,7 @@
 
 #include <algorithm>
 #include <cstring>
+#include <numeric>
 #include "helpers/utils.h"
 #include "helpers/imgui.h"
 #include "views/command_palette.h"
@@ -34,6 +35,23 @@ CommandPalette::CommandPalette(Config* config, Mpv* mpv) : View(config, mpv) {
     }
     pos = mpv->chapter;
   };
+  providers["scenes"] = [=, this](const char*) {
+    if (scenes == nullptr) return;
+    auto times = scenes->all();
+    auto now = mpv->property<double, MPV_FORMAT_DOUBLE>("time-pos");
+    pos = 0;
+    for (size_t i = 0; i < times.size(); i++) {
+      double time = times[i];
+      items.push_back({
+          fmt::format("Scene {}", i + 1),
+          "",
+          fmt::format("{:%H:%M:%S}", std::chrono::duration<int>((int)time)),
+          (int64_t)i,
+          [=, this]() { mpv->commandv("seek", fmt::format("{:.6f}", time).c_str(), "absolute+exact", nullptr); },
+      });
+      if (time <= now) pos = (int64_t)i;
+    }
+  };
   providers["playlist"] = [=, this](const char*) {
     for (auto& item : mpv->playlist) {
       std::string title = item.title;
@@ -83,6 +101,23 @@ CommandPalette::CommandPalette(Config* config, Mpv* mpv) : View(config, mpv) {
     }
     pos = 0;
   };
+  providers["files"] = [=, this](const char*) {
+    fileSearch.refresh();
+    streaming = true;
+    pos = 0;
+  };
+
+  worker = std::thread(&CommandPalette::matchLoop, this);
+}
+
+CommandPalette::~CommandPalette() {
+  {
+    std::lock_guard<std::mutex> l(workerLock);
+    workerQuit = true;
+  }
+  generation++;
+  workerCond.notify_one();
+  worker.join();
 }
 
 void CommandPalette::show(int n, const char** args) {
@@ -91,14 +126,25 @@ void CommandPalette::show(int n, const char** args) {
   if (!providers.contains(target)) return;
   auto callback = providers[target];
 
+  generation++;
+  fileSearch.cancel();
+  streaming = false;
   items.clear();
+  matches.clear();
   callback(n > 1 ? args[1] : nullptr);
+  buildIndex();
 
   View::show();
 }
 
 void CommandPalette::draw() {
-  if (items.empty()) return;
+  if (items.empty() && !streaming) return;
+  if (streaming) pollFiles();
+  {
+    std::lock_guard<std::mutex> l(workerLock);
+    if (finishedResult && finishedResult->generation == generation) applyResult(*finishedResult);
+    finishedResult.reset();
+  }
   if (m_open) {
     ImGui::OpenPopup("##command_palette");
     m_open = false;
@@ -120,9 +166,17 @@ void CommandPalette::draw() {
 
     drawInput();
     ImGui::Separator();
-    drawList(popupSize.x);
+    if (streaming && matches.empty() && fileSearch.running()) {
+      ImGui::BeginDisabled();
+      ImGui::TextUnformatted("views.command_palette.searching"_i18n);
+      ImGui::EndDisabled();
+    }
+    drawList();
 
     ImGui::EndPopup();
+  } else if (streaming) {
+    fileSearch.cancel();
+    streaming = false;
   }
 }
 
@@ -150,48 +204,66 @@ void CommandPalette::drawInput() {
   if (ImGui::IsItemFocused() && ImGui::IsKeyReleased(ImGuiKey_UpArrow)) focusInput = true;
 }
 
-void CommandPalette::drawList(float width) {
+void CommandPalette::drawList() {
   ImGui::BeginChild("##command_matches", ImVec2(0, 0), ImGuiChildFlags_None, ImGuiWindowFlags_NavFlattened);
-  float maxWidth = 0;
-  for (const auto& match : matches) {
-    auto width = ImGui::CalcTextSize(match.label.c_str()).x;
-    if (width > maxWidth) maxWidth = width;
+  if (labelWidth < 0) {
+    labelWidth = 0;
+    for (const auto &item : items) labelWidth = std::max(labelWidth, ImGui::CalcTextSize(item.label.c_str()).x);
   }
-  ImGuiWindow* window = ImGui::GetCurrentWindow();
   ImGuiStyle style = ImGui::GetStyle();
-  for (const auto& match : matches) {
-    std::string title = match.title;
-    if (title.empty()) title = match.tooltip;
-    ImVec2 contentAvail = ImGui::GetContentRegionAvail();
-    float lWidth = contentAvail.x;
-    auto rWidth = maxWidth + 2 * style.ItemInnerSpacing.x + style.ItemSpacing.x;
-    if (rWidth > 0) lWidth -= rWidth;
-
-    ImGui::PushID(&match);
-    ImGui::SetNextItemWidth(lWidth);
-    if (ImGui::Selectable("", false, ImGuiSelectableFlags_DontClosePopups)) {
-      pos = match.id;
-      match.callback();
-    }
-    if (!match.tooltip.empty() && ImGui::IsItemHovered(ImGuiHoveredFlags_DelayNormal))
-      ImGui::SetTooltip("%s", match.tooltip.c_str());
-    ImGui::SameLine();
-
-    bool selected = pos > 0 && match.id == pos;
-    auto color = ImGui::GetStyleColorVec4(selected ? ImGuiCol_CheckMark : ImGuiCol_Text);
-    ImGui::PushStyleColor(ImGuiCol_Text, color);
-    ImGui::TextEllipsis(title.c_str(), contentAvail.x - rWidth - style.ItemSpacing.x);
-    if (ImGui::IsWindowAppearing() && selected) ImGui::SetScrollHereY(0.25f);
-    ImGui::PopStyleColor();
-
-    if (!match.label.empty()) {
-      ImGui::SameLine(contentAvail.x - rWidth);
-      ImGui::BeginDisabled();
-      ImGui::Button(match.label.c_str());
-      ImGui::EndDisabled();
+  ImGuiListClipper clipper;
+  clipper.Begin((int)matches.size());
+  int selectedIdx = -1;
+  if (ImGui::IsWindowAppearing() && pos > 0) {
+    for (int i = 0; i < (int)matches.size(); i++) {
+      if (items[matches[i]].id != pos) continue;
+      selectedIdx = i;
+      clipper.IncludeItemByIndex(i);
+      break;
     }
+  }
+  while (clipper.Step()) {
+    for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+      const auto &match = items[matches[i]];
+      std::string title = match.title;
+      if (title.empty()) title = match.tooltip;
+      ImVec2 contentAvail = ImGui::GetContentRegionAvail();
+      float lWidth = contentAvail.x;
+      auto rWidth = labelWidth + 2 * style.ItemInnerSpacing.x + style.ItemSpacing.x;
+      if (rWidth > 0) lWidth -= rWidth;
+
+      ImGui::PushID(i);
+      ImGui::SetNextItemWidth(lWidth);
+      if (ImGui::Selectable("", false, ImGuiSelectableFlags_DontClosePopups)) {
+        pos = match.id;
+        match.callback();
+      }
+      if (!match.tooltip.empty() && ImGui::IsItemHovered(ImGuiHoveredFlags_DelayNormal))
+        ImGui::SetTooltip("%s", match.tooltip.c_str());
+      ImGui::SameLine();
 
-    ImGui::PopID();
+      bool selected = pos > 0 && match.id == pos;
+      auto color = ImGui::GetStyleColorVec4(selected ? ImGuiCol_CheckMark : ImGuiCol_Text);
+      ImGui::PushStyleColor(ImGuiCol_Text, color);
+      ImGui::TextEllipsis(title.c_str(), contentAvail.x - rWidth - style.ItemSpacing.x);
+      if (i == selectedIdx) ImGui::SetScrollHereY(0.25f);
+      ImGui::PopStyleColor();
+
+      if (!match.label.empty()) {
+        ImGui::SameLine(contentAvail.x - rWidth);
+        ImGui::BeginDisabled();
+        ImGui::Button(match.label.c_str());
+        ImGui::EndDisabled();
+      }
+
+      ImGui::PopID();
+    }
+  }
+  // only the best MaxMatches are listed
+  if (!streaming && lastResult.all.size() > matches.size()) {
+    ImGui::BeginDisabled();
+    ImGui::TextUnformatted(i18n_a("views.command_palette.more", lastResult.all.size() - matches.size()).c_str());
+    ImGui::EndDisabled();
   }
   if (filtered) {
     ImGui::SetScrollY(0.0f);
@@ -200,35 +272,156 @@ void CommandPalette::drawList(float width) {
   ImGui::EndChild();
 }
 
-void CommandPalette::match(const std::string& input) {
-  constexpr static auto MatchCommand = [](const std::string& input, const std::string& text) -> int {
-    if (input.empty()) return 1;
-    auto l_text = tolower(text);
-    auto l_input = tolower(input);
-    if (l_text.starts_with(l_input)) return 3;
-    if (l_text.find(l_input) != std::string::npos) return 2;
-    return 0;
-  };
+void CommandPalette::buildIndex() {
+  auto idx = std::make_shared<Index>();
+  idx->keys.reserve(items.size());
+  idx->masks.reserve(items.size());
+  for (const auto &item : items) {
+    auto &key = idx->keys.emplace_back(Fuzzy::Key(item.title), Fuzzy::Key(item.tooltip));
+    idx->masks.push_back(key.title.mask | key.tooltip.mask);
+  }
+  index = idx;
+  lastResult = MatchResult{};
+  labelWidth = -1;
+}
 
-  if (input.empty()) {
-    matches = items;
+void CommandPalette::match(const std::string &input) {
+  if (streaming) return searchFiles(input);
+  uint64_t gen = ++generation;
+  MatchJob job{gen, Fuzzy::fold(input), index};
+
+  // a query that only extends the last one can only narrow its matches
+  if (lastResult.index == index && job.query.starts_with(lastResult.query)) job.base = lastResult.all;
+
+  if (index->keys.size() < AsyncThreshold || Fuzzy::charMask(job.query) == 0) {
+    MatchResult result;
+    if (runMatch(job, result)) applyResult(result);
     return;
   }
 
-  std::vector<std::pair<CommandItem, int>> result;
+  {
+    std::lock_guard<std::mutex> l(workerLock);
+    pendingJob = std::move(job);
+  }
+  workerCond.notify_one();
+}
+
+bool CommandPalette::runMatch(const MatchJob &job, MatchResult &result) {
+  const auto &keys = job.index->keys;
+  const auto &masks = job.index->masks;
+  result.generation = job.generation;
+  result.query = job.query;
+  result.index = job.index;
+
+  uint64_t mask = Fuzzy::charMask(job.query);
+  if (mask == 0) {
+    result.all.resize(keys.size());
+    std::iota(result.all.begin(), result.all.end(), 0);
+    result.top = result.all;
+    return true;
+  }
+
+  std::vector<uint32_t> candidates;
+  if (job.base) {
+    for (auto i : *job.base)
+      if ((masks[i] & mask) == mask) candidates.push_back(i);
+  } else {
+    Fuzzy::prefilter(mask, masks.data(), masks.size(), candidates);
+  }
 
-  for (const auto& item : items) {
-    int score = MatchCommand(input, item.title) * 2;
-    if (score == 0) score = MatchCommand(input, item.tooltip);
-    if (score > 0) result.push_back(std::make_pair(item, score));
+  std::vector<std::pair<uint32_t, int>> scored;
+  for (size_t n = 0; n < candidates.size(); n++) {
+    if ((n & 0x3FF) == 0 && generation != job.generation) return false;
+    auto i = candidates[n];
+    int score = Fuzzy::score(job.query, keys[i].title.str) * 2;
+    if (score == 0) score = Fuzzy::score(job.query, keys[i].tooltip.str);
+    if (score > 0) scored.emplace_back(i, score);
   }
-  std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) {
+  result.all.reserve(scored.size());
+  for (auto &[i, _] : scored) result.all.push_back(i);
+
+  // only the best MaxMatches results are kept, so a partial sort is enough
+  auto middle = scored.begin() + std::min(scored.size(), MaxMatches);
+  std::partial_sort(scored.begin(), middle, scored.end(), [&](const auto &a, const auto &b) {
     if (a.second != b.second) return a.second > b.second;
-    if (a.first.title != b.first.title) return a.first.title < b.first.title;
-    return a.first.tooltip < b.first.tooltip;
+    auto &x = keys[a.first], &y = keys[b.first];
+    if (x.title.str != y.title.str) return x.title.str < y.title.str;
+    if (x.tooltip.str != y.tooltip.str) return x.tooltip.str < y.tooltip.str;
+    return a.first < b.first;
   });
+  result.top.reserve(middle - scored.begin());
+  for (auto it = scored.begin(); it != middle; ++it) result.top.push_back(it->first);
+  return generation == job.generation;
+}
 
-  matches.clear();
-  for (const auto& [item, _] : result) matches.push_back(item);
+void CommandPalette::applyResult(MatchResult &result) {
+  if (result.index != index) return;
+  matches = std::move(result.top);
+  lastResult = std::move(result);
+  filtered = true;
+}
+
+void CommandPalette::matchLoop() {
+  while (true) {
+    MatchJob job;
+    {
+      std::unique_lock<std::mutex> l(workerLock);
+      workerCond.wait(l, [this] { return workerQuit || pendingJob.has_value(); });
+      if (workerQuit) break;
+      job = std::move(*pendingJob);
+      pendingJob.reset();
+    }
+
+    MatchResult result;
+    if (!runMatch(job, result)) continue;
+
+    std::lock_guard<std::mutex> l(workerLock);
+    if (result.generation == generation) finishedResult = std::move(result);
+  }
+}
+void CommandPalette::searchFiles(const std::string &query) {
+  auto folded = Fuzzy::fold(query);
+  fileSearch.start(fileRoots(), folded, fileFilter ? fileFilter : [](const std::string &) { return true; });
+
+  // keep showing what still matches until the new walk catches up
+  std::vector<uint32_t> kept;
+  for (auto i : matches)
+    if (Fuzzy::score(folded, Fuzzy::fold(items[i].tooltip)) > 0) kept.push_back(i);
+  matches = std::move(kept);
+  filtered = true;
+}
+
+void CommandPalette::pollFiles() {
+  std::vector<FileSearch::Result> results;
+  if (!fileSearch.poll(results)) return;
+
+  items.clear();
+  for (auto &result : results) {
+    items.push_back({
+        result.name,
+        result.path,
+        "",
+        -1,
+        [=, this]() { mpv->commandv("loadfile", result.path.c_str(), nullptr); },
+    });
+    config->addGlyphs(result.path);
+  }
+  matches.resize(items.size());
+  std::iota(matches.begin(), matches.end(), 0);
+  labelWidth = -1;
+}
+
+std::vector<std::filesystem::path> CommandPalette::fileRoots() {
+  std::vector<std::filesystem::path> roots;
+  for (auto &root : config->Data.Files.Roots) roots.push_back(std::filesystem::u8path(root));
+  if (roots.empty()) {
+#ifdef _WIN32
+    char *home = getenv("USERPROFILE");
+#else
+    char *home = getenv("HOME");
+#endif
+    if (home != nullptr) roots.push_back(std::filesystem::u8path(home));
+  }
+  return roots;
 }
-}  // namespace ImPlay::Views
\ No newline at end of file
+}  // namespace ImPlay::Views
@@ -0,0 +1,195 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include "helpers/utils.h"
+#include "views/compare.h"
+
+namespace ImPlay::Views {
+Compare::Compare(Config *config, Mpv *mpv) : View(config, mpv) {}
+
+void Compare::open(const std::string &path) {
+  this->path = path;
+  other = std::make_unique<Mpv>();
+  other->option("vo", "libmpv");
+  other->option("hwdec", mpv->property("hwdec").c_str());
+  other->option("aid", "no");
+  other->option("keep-open", "yes");
+  other->option("pause", "yes");
+  other->init();
+
+  other->observeEvent(MPV_EVENT_FILE_LOADED, [this](void *data) {
+    seek();
+    other->property("pause", mpv->pause ? "yes" : "no");
+  });
+  other->observeEvent(MPV_EVENT_PLAYBACK_RESTART, [this](void *data) { seeking = false; });
+  // a seek past the end, or into a file that failed, never restarts playback
+  other->observeEvent(MPV_EVENT_END_FILE, [this](void *data) { seeking = false; });
+  otherSpeed = 1;
+  observe();
+}
+
+// the player's observers stay registered, they do nothing while inactive
+void Compare::observe() {
+  if (observing) return;
+  observing = true;
+  mpv->observeProperty<int, MPV_FORMAT_FLAG>("pause", [this](int flag) {
+    if (active_) other->property("pause", flag ? "yes" : "no");
+  });
+  mpv->observeProperty<double, MPV_FORMAT_DOUBLE>("speed", [this](double val) { speed = val; });
+  mpv->observeProperty<char *, MPV_FORMAT_STRING>("media-title", [this](char *data) { title = data; });
+  mpv->observeEvent(MPV_EVENT_PLAYBACK_RESTART, [this](void *data) {
+    if (active_) seek();
+  });
+}
+
+void Compare::initRender(GLAddrLoadFunc load) {
+  other->updateCb() = [this](Mpv *ctx) {
+    pending = true;
+    if (updateCb) updateCb();
+  };
+  other->initRender(load);
+
+  glGenFramebuffers(1, &fbo);
+  glGenTextures(1, &tex);
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glBindTexture(GL_TEXTURE_2D, tex);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  texWidth = texHeight = 0;
+
+  other->commandv("loadfile", path.c_str(), nullptr);
+  active_ = true;
+  if (redrawCb) redrawCb();
+}
+
+void Compare::close() {
+  if (!other) return;
+  active_ = false;
+  glDeleteTextures(1, &tex);
+  glDeleteFramebuffers(1, &fbo);
+  other.reset();
+  seeking = false;
+  if (redrawCb) redrawCb();
+}
+
+bool Compare::render() {
+  if (!active_) return false;
+
+  int w = width, h = height;
+  bool resized = w != texWidth || h != texHeight;
+  bool update = pending.exchange(false);
+  if (w <= 0 || h <= 0 || !(update || resized)) return false;
+  if (!other->wantRender() && !resized) return false;
+
+  if (resized) {
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    texWidth = w;
+    texHeight = h;
+  }
+  other->render(w, h, fbo, false);
+  return true;
+}
+
+void Compare::cycleLayout() {
+  wipe = !wipe;
+  if (active_ && redrawCb) redrawCb();
+}
+
+void Compare::seek() {
+  double pos = mpv->property<double, MPV_FORMAT_DOUBLE>("time-pos");
+  other->commandv("seek", fmt::format("{:.6f}", pos).c_str(), "absolute+exact", nullptr);
+  seeking = true;
+  seekTime = ImGui::GetTime();
+  target = pos;
+}
+
+void Compare::sync() {
+  double now = ImGui::GetTime();
+  if (seeking && now - seekTime > SeekTimeout) seeking = false;
+  if (seeking || !mpv->playing() || now - lastSync < 0.1) return;
+  lastSync = now;
+
+  double pos = mpv->property<double, MPV_FORMAT_DOUBLE>("time-pos");
+  // a frame step, or a seek the player didn't finish with a playback restart
+  if (mpv->pause) {
+    if (pos != target) seek();
+    return;
+  }
+  double drift = other->property<double, MPV_FORMAT_DOUBLE>("time-pos") - pos;
+  if (std::abs(drift) > 0.5) return seek();
+
+  double s = speed * (1 - std::clamp(drift, -0.05, 0.05));
+  if (std::abs(s - otherSpeed) > 0.001) {
+    other->property<double, MPV_FORMAT_DOUBLE>("speed", s);
+    otherSpeed = s;
+  }
+}
+
+void Compare::draw() {
+  if (!active_) return;
+  other->waitEvent();
+  sync();
+  if (!wipe) return;
+
+  auto vp = ImGui::GetMainViewport();
+  float w = scaled(0.6f), x = vp->WorkPos.x + vp->WorkSize.x * split;
+  ImGui::SetNextWindowPos(ImVec2(x - w / 2, vp->WorkPos.y));
+  ImGui::SetNextWindowSize(ImVec2(w, vp->WorkSize.y));
+#ifdef IMGUI_HAS_VIEWPORT
+  ImGui::SetNextWindowViewport(vp->ID);
+#endif
+  ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0, 0));
+  ImGui::Begin("##compare_wipe", nullptr,
+               ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoBackground | ImGuiWindowFlags_NoSavedSettings |
+                   ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoNav | ImGuiWindowFlags_NoFocusOnAppearing);
+  ImGui::PopStyleVar();
+  ImGui::InvisibleButton("##split", ImGui::GetContentRegionAvail());
+  if (ImGui::IsItemHovered() || ImGui::IsItemActive()) ImGui::SetMouseCursor(ImGuiMouseCursor_ResizeEW);
+  if (ImGui::IsItemActive())
+    split = std::clamp((ImGui::GetIO().MousePos.x - vp->WorkPos.x) / vp->WorkSize.x, 0.0f, 1.0f);
+  ImGui::End();
+}
+
+void Compare::drawVideo(ImTextureID main) {
+  auto vp = ImGui::GetMainViewport();
+  auto drawList = ImGui::GetBackgroundDrawList(vp);
+  auto scale = ImGui::GetIO().DisplayFramebufferScale;
+  auto texture = reinterpret_cast<ImTextureID>(static_cast<intptr_t>(tex));
+  ImVec2 pos = vp->WorkPos, size = vp->WorkSize, otherPos = pos;
+
+  if (wipe) {
+    float x = pos.x + size.x * split;
+    drawList->AddImage(main, pos, pos + size);
+    drawList->AddImage(texture, ImVec2(x, pos.y), pos + size, ImVec2(split, 0), ImVec2(1, 1));
+    drawList->AddLine(ImVec2(x, pos.y), ImVec2(x, pos.y + size.y), IM_COL32_WHITE, scaled(0.1f));
+    otherPos.x = x;
+  } else {
+    size.x /= 2;
+    otherPos.x += size.x;
+    drawList->AddImage(main, pos, pos + size);
+    drawList->AddImage(texture, otherPos, otherPos + size);
+  }
+
+  // both videos render at the size they're shown at
+  int w = (int)(size.x * scale.x), h = (int)(size.y * scale.y);
+  if (wipe) w = (int)(vp->WorkSize.x * scale.x);
+  if (width != w || height != h) {
+    width = w;
+    height = h;
+    if (updateCb) updateCb();
+  }
+
+  auto padding = scaled(ImVec2(0.5f, 0.5f));
+  auto name = std::filesystem::u8path(path).filename().u8string();
+  drawList->AddText(pos + padding, IM_COL32_WHITE, title.c_str());
+  drawList->AddText(otherPos + padding, IM_COL32_WHITE, std::string(name.begin(), name.end()).c_str());
+}
+}  // namespace ImPlay::Views
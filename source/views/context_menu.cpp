@@ -100,6 +100,7 @@ std::vector<ContextMenu::Item> ContextMenu::build() {
         {TYPE_NORMAL, "add chapter 1", "menu.playback.next_chapter", ICON_FA_FAST_FORWARD, "PGUP", chapters.size() > 1},
         {TYPE_NORMAL, "add chapter -1", "menu.playback.previous_chapter", ICON_FA_FAST_BACKWARD, "PGDWN", chapters.size() > 1},
         {TYPE_NORMAL, "script-message-to implay command-palette chapters", "menu.chapters"},
+        {TYPE_NORMAL, "script-message-to implay command-palette scenes", "menu.playback.scenes"},
         {TYPE_SEPARATOR},
         {TYPE_NORMAL, "ab-loop", "menu.playback.ab_loop", "", "l", playing},
         {TYPE_NORMAL, "cycle-values loop-file inf no", "menu.playback.file_loop", "", "L", playing},
@@ -179,6 +180,9 @@ std::vector<ContextMenu::Item> ContextMenu::build() {
         {TYPE_NORMAL, "cycle-values hwdec auto no", "menu.video.hw_decoding", "", "Ctrl+h"},
         {TYPE_NORMAL, "cycle deinterlace", "menu.video.deinterlace", "", "d"},
         {TYPE_SEPARATOR},
+        {TYPE_NORMAL, "script-message-to implay compare", "menu.video.compare", ICON_FA_COLUMNS, "", mpv->playing()},
+        {TYPE_NORMAL, "script-message-to implay compare-layout", "menu.video.compare_layout", "", "", mpv->playing()},
+        {TYPE_SEPARATOR},
         {TYPE_NORMAL, "script-message-to implay quickview video", "menu.quickview"},
       }},
       {TYPE_SUBMENU, "", "menu.subtitle", ICON_FA_FONT, "", true, false, {
@@ -209,6 +213,7 @@ std::vector<ContextMenu::Item> ContextMenu::build() {
         {TYPE_NORMAL, "playlist-shuffle", "menu.playlist.shuffle", ICON_FA_RANDOM},
         {TYPE_NORMAL, "cycle-values loop-playlist inf no", "menu.playlist.loop"},
         {TYPE_NORMAL, "playlist-clear", "menu.playlist.clear"},
+        {TYPE_NORMAL, "script-message-to implay video-wall", "menu.playlist.video_wall", ICON_FA_TH, "", playlist.size() > 1},
         {TYPE_SEPARATOR},
         {TYPE_NORMAL, "script-message-to implay quickview playlist", "menu.quickview"},
         {.type = TYPE_CALLBACK, .callback = [playlist, this](){ drawPlaylist(playlist); }},
@@ -229,6 +234,7 @@ std::vector<ContextMenu::Item> ContextMenu::build() {
         {TYPE_NORMAL, "cycle border", "menu.tools.window_border", ICON_FA_BORDER_NONE},
         {TYPE_NORMAL, "cycle window-dragging", "menu.tools.window_dragging", ICON_FA_HAND_POINTER},
         {TYPE_NORMAL, "cycle ontop", "menu.tools.window_ontop", ICON_FA_ARROW_UP, "T"},
+        {TYPE_NORMAL, "script-message-to implay mirror", "menu.tools.mirror", ICON_FA_DESKTOP},
         {TYPE_SEPARATOR},
         {TYPE_NORMAL, "show-progress", "menu.tools.show_progress", ICON_FA_SPINNER, "o", playing},
         {TYPE_NORMAL, "script-binding stats/display-stats-toggle", "menu.tools.show_stats", ICON_FA_CHART_BAR, "I"},
@@ -237,6 +243,7 @@ std::vector<ContextMenu::Item> ContextMenu::build() {
         {.type = TYPE_CALLBACK, .callback = [this](){ drawProfilelist(); }},
         {TYPE_SEPARATOR},
         {TYPE_NORMAL, "script-message-to implay metrics", "menu.tools.debug", "", "`"},
+        {TYPE_NORMAL, "script-message-to implay log-viewer", "menu.tools.log_viewer"},
         {TYPE_NORMAL, "script-message-to implay open-config-dir", "menu.tools.open_config_dir"},
       }},
       {.type = TYPE_CALLBACK, .callback = [this](){ drawThemelist(); }},
@@ -1,17 +1,27 @@
 // Copyright (c) 2022-2023 tsl0922. All rights reserved.
 // SPDX-License-Identifier: GPL-2.0-only
 
+#include <algorithm>
+#include <chrono>
 #include <cstdarg>
 #include <cstdio>
+#include <cstring>
 #include <map>
 #include "helpers/utils.h"
 #include "helpers/imgui.h"
+#include "helpers/startup_trace.h"
 #include "views/debug.h"
 
 namespace ImPlay::Views {
-Debug::Debug(Config* config, Mpv* mpv) : View(config, mpv) { console = new Console(mpv); }
+Debug::Debug(Config* config, Mpv* mpv) : View(config, mpv) {
+  console = new Console(config, mpv);
+  performance = new Performance(mpv);
+}
 
-Debug::~Debug() { delete console; }
+Debug::~Debug() {
+  delete performance;
+  delete console;
+}
 
 void Debug::init() { console->init(config->Data.Debug.LogLevel.c_str(), config->Data.Debug.LogLimit); }
 
@@ -21,7 +31,9 @@ void Debug::show() {
 }
 
 void Debug::draw() {
+  performance->setActive(m_open);
   if (!m_open) return;
+  performance->addFrameTime(ImGui::GetIO().DeltaTime * 1000.0f);
   ImVec2 wPos = ImGui::GetMainViewport()->WorkPos;
   ImVec2 wSize = ImGui::GetMainViewport()->WorkSize;
   ImGui::SetNextWindowSizeConstraints(ImVec2(scaled(35), scaled(45)), ImVec2(FLT_MAX, FLT_MAX));
@@ -30,6 +42,7 @@ void Debug::draw() {
                           ImVec2(0.2f, 0.5f));
   if (ImGui::Begin("views.debug.title"_i18n, &m_open, ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoScrollbar)) {
     drawHeader();
+    drawPerformance();
     drawProperties("views.debug.options"_i18n, options);
     drawProperties("views.debug.properties"_i18n, properties);
     drawBindings();
@@ -59,6 +72,13 @@ void Debug::drawHeader() {
   ImGui::Spacing();
 }
 
+void Debug::drawPerformance() {
+  if (m_node != "Performance") ImGui::SetNextItemOpen(false, ImGuiCond_Always);
+  if (!ImGui::CollapsingHeader("views.debug.performance"_i18n)) return;
+  m_node = "Performance";
+  performance->draw();
+}
+
 void Debug::drawConsole() {
   ImGui::SetNextItemOpen(true, ImGuiCond_Once);
   if (m_node != "Console") ImGui::SetNextItemOpen(false, ImGuiCond_Always);
@@ -275,7 +295,7 @@ void Debug::drawPropNode(const char* name, mpv_node& node, int depth) {
         break;
       case MPV_FORMAT_NONE:
       default:
-        value = i18n("views.debug.properties.invalid");
+        value = "views.debug.properties.invalid"_i18n.str();
         color = style.Colors[ImGuiCol_TextDisabled];
         break;
     }
@@ -319,7 +339,138 @@ void Debug::drawPropNode(const char* name, mpv_node& node, int depth) {
   }
 }
 
-Debug::Console::Console(Mpv* mpv) : mpv(mpv) {
+Debug::Performance::Performance(Mpv* mpv) : mpv(mpv) { worker = std::thread(&Performance::sampleLoop, this); }
+
+Debug::Performance::~Performance() {
+  {
+    std::lock_guard<std::mutex> l(lock);
+    quit = true;
+  }
+  cond.notify_one();
+  worker.join();
+}
+
+void Debug::Performance::setActive(bool value) {
+  {
+    std::lock_guard<std::mutex> l(lock);
+    if (active == value) return;
+    active = value;
+    primed = false;
+  }
+  cond.notify_one();
+}
+
+void Debug::Performance::addFrameTime(float ms) {
+  std::lock_guard<std::mutex> l(lock);
+  frameTimeMax = std::max(frameTimeMax, ms);
+}
+
+void Debug::Performance::sampleLoop() {
+  using clock = std::chrono::steady_clock;
+  auto interval = std::chrono::microseconds(1000000 / SampleRate);
+  auto next = clock::now();
+  while (true) {
+    {
+      std::unique_lock<std::mutex> l(lock);
+      cond.wait(l, [this] { return quit || active; });
+      if (quit) break;
+    }
+    sample();
+
+    next += interval;
+    if (next < clock::now()) next = clock::now() + interval;
+    std::unique_lock<std::mutex> l(lock);
+    if (cond.wait_until(l, next, [this] { return quit; })) break;
+  }
+}
+
+void Debug::Performance::sample() {
+  // property reads block this thread only, never the UI
+  float fps = (float)mpv->property<double, MPV_FORMAT_DOUBLE>("estimated-vf-fps");
+  float avsync = (float)mpv->property<double, MPV_FORMAT_DOUBLE>("avsync") * 1000.0f;
+  float cache = (float)mpv->property<double, MPV_FORMAT_DOUBLE>("demuxer-cache-duration");
+  float speed = (float)mpv->property<int64_t, MPV_FORMAT_INT64>("cache-speed") / 1024.0f;
+  std::array<int64_t, MetricCount> now{};
+  now[FrameDrops] = mpv->property<int64_t, MPV_FORMAT_INT64>("frame-drop-count");
+  now[DecoderDrops] = mpv->property<int64_t, MPV_FORMAT_INT64>("decoder-frame-drop-count");
+  now[VoDelayed] = mpv->property<int64_t, MPV_FORMAT_INT64>("vo-delayed-frame-count");
+
+  std::lock_guard<std::mutex> l(lock);
+  series[VfFps].push(fps);
+  series[AvSync].push(avsync);
+  series[CacheDuration].push(cache);
+  series[CacheSpeed].push(speed);
+  // counters are plotted as the increase per sample, they restart from 0 on a new file
+  for (auto metric : {FrameDrops, DecoderDrops, VoDelayed}) {
+    int64_t delta = primed && now[metric] >= counters[metric] ? now[metric] - counters[metric] : 0;
+    series[metric].push((float)delta);
+    counters[metric] = now[metric];
+  }
+  series[FrameTime].push(frameTimeMax);
+  frameTimeMax = 0;
+  primed = true;
+}
+
+void Debug::Performance::draw() {
+  std::lock_guard<std::mutex> l(lock);
+  ImGui::TextDisabled("%s", i18n_a("views.debug.performance.hint", SampleRate, Series::Capacity / SampleRate).c_str());
+  drawSeries(VfFps, "estimated-vf-fps", "fps");
+  drawSeries(FrameDrops, "frame-drop-count", "/tick");
+  drawSeries(DecoderDrops, "decoder-frame-drop-count", "/tick");
+  drawSeries(VoDelayed, "vo-delayed-frame-count", "/tick");
+  drawSeries(AvSync, "avsync", "ms");
+  drawSeries(CacheDuration, "demuxer-cache-duration", "s");
+  drawSeries(CacheSpeed, "cache-speed", "KiB/s");
+  drawSeries(FrameTime, "views.debug.performance.frame_time"_i18n, "ms");
+
+  ImGui::Text("%s", "views.debug.performance.startup"_i18n.c_str());
+  ImGui::Indent();
+  for (auto& [name, ms] : StartupTrace::get().marks()) {
+    ImGui::Text("%-12s", name.c_str());
+    ImGui::SameLine();
+    ImGui::TextColored(ImGui::GetStyleColorVec4(ImGuiCol_CheckMark), "%.1f", ms);
+  }
+  ImGui::Unindent();
+}
+
+void Debug::Performance::drawSeries(Metric metric, const char* label, const char* unit) {
+  auto& s = series[metric];
+  float min, avg, max;
+  s.stats(min, avg, max);
+  ImGui::Text("%s", label);
+  ImGui::SameLine();
+  ImGui::TextColored(ImGui::GetStyleColorVec4(ImGuiCol_CheckMark), "%.2f %s", s.last(), unit);
+  auto overlay = fmt::format("min {:.2f}  avg {:.2f}  max {:.2f}", min, avg, max);
+  int offset = s.count < Series::Capacity ? 0 : s.head;
+  ImGui::PushID(metric);
+  float scaleMin = std::min(min, 0.0f), scaleMax = max > scaleMin ? max : scaleMin + 1;
+  ImGui::PlotLines("##plot", s.values.data(), s.count, offset, overlay.c_str(), scaleMin, scaleMax,
+                   ImVec2(-FLT_MIN, scaled(3)));
+  ImGui::PopID();
+}
+
+void Debug::Performance::Series::push(float value) {
+  values[head] = value;
+  head = (head + 1) % Capacity;
+  if (count < Capacity) count++;
+}
+
+float Debug::Performance::Series::last() const { return count > 0 ? values[(head + Capacity - 1) % Capacity] : 0; }
+
+void Debug::Performance::Series::stats(float& min, float& avg, float& max) const {
+  min = avg = max = 0;
+  if (count == 0) return;
+  min = max = values[0];
+  float sum = 0;
+  for (int i = 0; i < count; i++) {
+    min = std::min(min, values[i]);
+    max = std::max(max, values[i]);
+    sum += values[i];
+  }
+  avg = sum / count;
+}
+
+Debug::Console::Console(Config* config, Mpv* mpv) : config(config), mpv(mpv) {
   ClearLog();
   memset(InputBuf, 0, sizeof(InputBuf));
 }
@@ -332,9 +483,9 @@ Debug::Console::~Console() {
 
 void Debug::Console::init(const char* level, int limit) {
   LogLevel = level;
-  LogLimit = limit;
+  SetLimit(limit);
   mpv->requestLog(level, [this](const char* prefix, const char* level, const char* text) {
-    AddLog(level, "[%s] %s", prefix, text);
+    AddLog(level, prefix, text);
   });
 }
 
@@ -346,62 +497,163 @@ void Debug::Console::initCommands(std::vector<std::pair<std::string, std::string
 }
 
 void Debug::Console::ClearLog() {
-  for (int i = 0; i < Items.Size; i++) free(Items[i].Str);
   Items.clear();
+  Head = 0;
+  Arena.Clear();
 }
 
 void Debug::Console::AddLog(const char* level, const char* fmt, ...) {
   std::va_list args;
   va_start(args, fmt);
+  char buf[1024];
+  int size = std::vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+  if (size < 0) return;
 
-  int size;
-  std::va_list copy;
-  va_copy(copy, args);
-  size = std::vsnprintf(nullptr, 0, fmt, copy);
-  va_end(copy);
-
-  char buf[size + 1];
-  std::vsnprintf(buf, size, fmt, args);
-  buf[size] = '\0';
+  if (size < (int)sizeof(buf)) {
+    AddLog(level, "", std::string_view(buf, size));
+    return;
+  }
+  std::string str(size, '\0');
+  va_start(args, fmt);
+  std::vsnprintf(str.data(), size + 1, fmt, args);
   va_end(args);
+  AddLog(level, "", str);
+}
 
-  int fontIdx = 1;  // mono
-  const char* p = buf;
-  auto mono = ImGui::GetIO().Fonts->Fonts[fontIdx];
-  while (*p) {
-    if (*p != '\n' && *p != '\r' && !mono->FindGlyphNoFallback((ImWchar)*p)) {
-      fontIdx = 0;  // unicode
-      break;
+// true if every byte is 7-bit ASCII, checked 8 bytes at a time
+static bool isAscii(std::string_view str) {
+  size_t i = 0;
+  for (; i + 8 <= str.size(); i += 8) {
+    uint64_t v;
+    memcpy(&v, str.data() + i, sizeof(v));
+    if (v & 0x8080808080808080ull) return false;
+  }
+  for (; i < str.size(); i++)
+    if (str[i] & 0x80) return false;
+  return true;
+}
+
+void Debug::Console::AddLog(const char* level, const char* prefix, std::string_view text) {
+  if (LogLimit <= 0) return;
+  while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) text.remove_suffix(1);
+
+  const char* str;
+  if (prefix == nullptr || *prefix == '\0') {
+    str = Arena.Push(text);
+  } else {
+    fmt::memory_buffer line;
+    fmt::format_to(std::back_inserter(line), "[{}] {}", prefix, text);
+    str = Arena.Push(std::string_view(line.data(), line.size()));
+  }
+  LogItem item{str, Intern(level ? level : ""), Intern(prefix ? prefix : ""), isAscii(text)};
+  if (!item.Mono) config->addGlyphs(text);
+
+  if (Items.size() < (size_t)LogLimit) {
+    Items.push_back(item);
+    return;
+  }
+  Arena.Pop();
+  Items[Head] = item;
+  Head = (Head + 1) % Items.size();
+}
+
+void Debug::Console::SetLimit(int limit) {
+  LogLimit = limit;
+  size_t cap = std::max(limit, 0);
+  std::rotate(Items.begin(), Items.begin() + Head, Items.end());
+  Head = 0;
+  if (Items.size() <= cap) return;
+  size_t drop = Items.size() - cap;
+  for (size_t i = 0; i < drop; i++) Arena.Pop();
+  Items.erase(Items.begin(), Items.begin() + drop);
+}
+
+const char* Debug::Console::Intern(std::string_view str) {
+  auto it = Interned.find(str);
+  if (it == Interned.end()) it = Interned.emplace(str).first;
+  return it->c_str();
+}
+
+const char* Debug::Console::LogArena::Push(std::string_view str) {
+  size_t need = str.size() + 1;
+  if (Chunks.empty() || Chunks.back().Used + need > Chunks.back().Size) {
+    if (need <= ChunkSize && !Spare.empty()) {
+      Chunks.push_back(std::move(Spare.back()));
+      Spare.pop_back();
+    } else {
+      Chunk chunk;
+      chunk.Size = std::max(need, ChunkSize);
+      chunk.Data = std::make_unique<char[]>(chunk.Size);
+      Chunks.push_back(std::move(chunk));
     }
-    p++;
   }
+  auto& chunk = Chunks.back();
+  char* p = chunk.Data.get() + chunk.Used;
+  memcpy(p, str.data(), str.size());
+  p[str.size()] = '\0';
+  chunk.Used += need;
+  chunk.Lines++;
+  return p;
+}
 
-  Items.push_back({ImStrdup(buf), level, fontIdx});
-  if (Items.Size > LogLimit) {
-    int offset = Items.Size - LogLimit;
-    for (int i = 0; i < offset; i++) free(Items[i].Str);
-    Items.erase(Items.begin(), Items.begin() + offset);
+void Debug::Console::LogArena::Pop() {
+  if (Chunks.empty()) return;
+  auto& chunk = Chunks.front();
+  if (--chunk.Lines > 0) return;
+  if (Chunks.size() == 1) {
+    chunk.Used = 0;
+    return;
+  }
+  // keep a few chunks around so a busy log doesn't hit the allocator
+  if (chunk.Size == ChunkSize && Spare.size() < 4) {
+    chunk.Used = 0;
+    Spare.push_back(std::move(chunk));
   }
+  Chunks.pop_front();
+}
+
+void Debug::Console::LogArena::Clear() {
+  Chunks.clear();
+  Spare.clear();
 }
 
 ImVec4 Debug::Console::LogColor(const char* level) {
-  std::map<std::string, ImVec4> logColors = {
+  static const std::map<std::string, ImVec4, std::less<>> logColors = {
       {"fatal", ImVec4{0.804f, 0, 0, 1.0f}},        {"error", ImVec4{0.804f, 0, 0, 1.0f}},
       {"warn", ImVec4{0.804f, 0.804f, 0, 1.0f}},    {"info", ImVec4{1.0f, 1.0f, 1.0f, 1.0f}},
       {"status", ImVec4{1.0f, 1.0f, 1.0f, 1.0f}},   {"v", ImVec4{0.075f, 0.631f, 0.055f, 1.0f}},
       {"debug", ImVec4{0.50f, 0.50f, 0.50f, 1.0f}}, {"trace", ImVec4{0.30f, 0.30f, 0.30f, 1.0f}},
   };
-  if (level == nullptr || !logColors.contains(level)) level = "status";
-  return logColors[level];
+  auto it = level != nullptr ? logColors.find(std::string_view(level)) : logColors.end();
+  if (it == logColors.end()) it = logColors.find("status");
+  return it->second;
+}
+
+void Debug::Console::DrawItem(const LogItem& item) {
+  ImGui::PushStyleColor(ImGuiCol_Text, LogColor(item.Lev));
+  ImGui::PushFont(ImGui::GetIO().Fonts->Fonts[item.Mono ? 1 : 0]);
+  ImGui::TextUnformatted(item.Str);
+  ImGui::PopFont();
+  ImGui::PopStyleColor();
 }
 
 void Debug::Console::draw() {
   ImGui::TextUnformatted("views.debug.console.log.limit"_i18n);
   ImGui::SameLine();
   ImGui::SetNextItemWidth(scaled(3));
-  ImGui::InputInt("##console.log.limit", &LogLimit, 0);
+  // each keystroke would resize the ring, dropping lines on the way to a bigger limit
+  ImGui::InputInt("##console.log.limit", &LimitInput, 0);
+  if (ImGui::IsItemDeactivatedAfterEdit())
+    SetLimit(LimitInput);
+  else if (!ImGui::IsItemActive())
+    LimitInput = LogLimit;
   ImGui::SameLine();
-  ImGui::TextDisabled("(%d/%d)", Items.Size, LogLimit);
+  ImGui::TextDisabled("(%d/%d)", (int)Items.size(), LogLimit);
+  if (auto dropped = mpv->droppedLogs(); dropped > 0) {
+    ImGui::SameLine();
+    ImGui::TextColored(LogColor("warn"), "%s", i18n_a("views.debug.console.log.dropped", dropped).c_str());
+  }
   ImGui::SameLine();
   ImGui::TextUnformatted("views.debug.console.log.level"_i18n);
   ImGui::SameLine();
@@ -433,20 +685,24 @@ void Debug::Console::draw() {
       ImGui::MenuItem("views.debug.console.log.menu.auto_scroll"_i18n, nullptr, &AutoScroll);
       if (ImGui::MenuItem("views.debug.console.log.menu.clear"_i18n)) ClearLog();
       ImGui::MenuItem("views.debug.console.log.menu.copy"_i18n, nullptr, &copy_to_clipboard);
+      if (ImGui::MenuItem("views.debug.console.log.menu.viewer"_i18n))
+        mpv->command("script-message-to implay log-viewer");
       ImGui::EndPopup();
     }
 
     ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(4, 1));
     if (copy_to_clipboard) ImGui::LogToClipboard();
-    for (int i = 0; i < Items.Size; i++) {
-      auto item = Items[i];
-      if (!Filter.PassFilter(item.Str)) continue;
-
-      ImGui::PushStyleColor(ImGuiCol_Text, LogColor(item.Lev));
-      ImGui::PushFont(ImGui::GetIO().Fonts->Fonts[item.FontIdx]);
-      ImGui::TextUnformatted(item.Str);
-      ImGui::PopFont();
-      ImGui::PopStyleColor();
+    size_t count = Items.size();
+    if (Filter.IsActive() || copy_to_clipboard) {
+      for (size_t i = 0; i < count; i++) {
+        auto& item = Items[(Head + i) % count];
+        if (Filter.PassFilter(item.Str)) DrawItem(item);
+      }
+    } else {
+      ImGuiListClipper clipper;
+      clipper.Begin((int)count);
+      while (clipper.Step())
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) DrawItem(Items[(Head + i) % count]);
     }
     if (copy_to_clipboard) ImGui::LogFinish();
 
@@ -0,0 +1,209 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <algorithm>
+#include <climits>
+#include "helpers/imgui.h"
+#include "helpers/nfd.h"
+#include "helpers/utils.h"
+#include "views/log_viewer.h"
+
+namespace ImPlay::Views {
+static const ImVec4 levelColors[] = {
+    {0.804f, 0, 0, 1.0f},            // fatal
+    {0.804f, 0, 0, 1.0f},            // error
+    {0.804f, 0.804f, 0, 1.0f},       // warn
+    {1.0f, 1.0f, 1.0f, 1.0f},        // info
+    {1.0f, 1.0f, 1.0f, 1.0f},        // status
+    {0.075f, 0.631f, 0.055f, 1.0f},  // v
+    {0.50f, 0.50f, 0.50f, 1.0f},     // debug
+    {0.30f, 0.30f, 0.30f, 1.0f},     // trace
+};
+
+LogViewer::LogViewer(Config *config, Mpv *mpv) : View(config, mpv) {}
+
+void LogViewer::show(int n, const char **args) {
+  auto live = std::filesystem::path(config->dir()) / "implay.log";
+  if (n > 0)
+    open(std::filesystem::u8path(args[0]));
+  else if (!index.isOpen() && std::filesystem::exists(live))
+    open(live);
+  m_open = true;
+}
+
+void LogViewer::open(const std::filesystem::path &path) {
+  try {
+    index.open(path);
+    error.clear();
+    cursor = -1;
+  } catch (const std::exception &e) {
+    error = e.what();
+  }
+}
+
+void LogViewer::draw() {
+  if (!m_open) return;
+  if (index.isOpen() && ImGui::GetTime() - lastRefresh > 1.0) {
+    index.refresh();
+    lastRefresh = ImGui::GetTime();
+  }
+
+  ImVec2 wPos = ImGui::GetMainViewport()->WorkPos;
+  ImVec2 wSize = ImGui::GetMainViewport()->WorkSize;
+  ImGui::SetNextWindowSize(ImVec2(wSize.x * 0.7f, wSize.y * 0.7f), ImGuiCond_FirstUseEver);
+  ImGui::SetNextWindowPos(ImVec2(wPos.x + wSize.x * 0.5f, wPos.y + wSize.y * 0.5f), ImGuiCond_FirstUseEver,
+                          ImVec2(0.5f, 0.5f));
+  if (ImGui::Begin("views.log_viewer.title"_i18n, &m_open, ImGuiWindowFlags_NoCollapse)) {
+    drawToolbar();
+    drawSearch();
+    ImGui::Separator();
+    drawLines();
+  }
+  ImGui::End();
+  if (!m_open) index.close();
+}
+
+void LogViewer::drawToolbar() {
+  if (ImGui::Button("views.log_viewer.open"_i18n)) {
+    if (auto res = NFD::openFile({{"Log Files", "log,txt"}})) open(*res);
+  }
+  ImGui::SameLine();
+  if (ImGui::Button("views.log_viewer.live"_i18n)) open(std::filesystem::path(config->dir()) / "implay.log");
+  ImGui::SameLine();
+  if (index.isOpen()) {
+    ImGui::TextUnformatted(index.path().string().c_str());
+    ImGui::SameLine();
+    ImGui::TextDisabled("%s", i18n_a("views.log_viewer.lines", index.lineCount()).c_str());
+    if (index.indexing()) {
+      ImGui::SameLine();
+      ImGui::TextDisabled("%s", i18n("views.log_viewer.indexing").c_str());
+    }
+  } else {
+    ImGui::TextDisabled("%s", i18n("views.log_viewer.empty").c_str());
+  }
+  if (!error.empty()) ImGui::TextColored(levelColors[1], "%s", error.c_str());
+}
+
+void LogViewer::drawSearch() {
+  bool changed = false;
+  ImGui::SetNextItemWidth(scaled(15));
+  changed |= ImGui::InputTextWithHint("##log.pattern", "views.log_viewer.search"_i18n, pattern, sizeof(pattern));
+  if (ImGui::IsItemFocused() && ImGui::IsKeyPressed(ImGuiKey_Enter)) jump(!ImGui::GetIO().KeyShift);
+  ImGui::SameLine();
+  changed |= ImGui::Checkbox("views.log_viewer.regex"_i18n, &regex);
+  ImGui::SameLine();
+  changed |= ImGui::Checkbox("views.log_viewer.case"_i18n, &matchCase);
+  ImGui::SameLine();
+  ImGui::SetNextItemWidth(scaled(6));
+  std::string preview = level < 0 ? i18n("views.log_viewer.level.all") : LogIndex::Levels[level];
+  if (ImGui::BeginCombo("##log.level", preview.c_str())) {
+    if (ImGui::Selectable("views.log_viewer.level.all"_i18n, level < 0)) {
+      level = -1;
+      changed = true;
+    }
+    for (int i = 0; i < (int)std::size(LogIndex::Levels); i++) {
+      ImGui::PushStyleColor(ImGuiCol_Text, levelColors[i]);
+      if (ImGui::Selectable(LogIndex::Levels[i], level == i)) {
+        level = i;
+        changed = true;
+      }
+      ImGui::PopStyleColor();
+    }
+    ImGui::EndCombo();
+  }
+  ImGui::SameLine();
+  ImGui::SetNextItemWidth(scaled(8));
+  changed |= ImGui::InputTextWithHint("##log.prefix", "views.log_viewer.prefix"_i18n, prefix, sizeof(prefix));
+  if (changed) search();
+
+  ImGui::SameLine();
+  if (ImGui::ArrowButton("##log.prev", ImGuiDir_Up)) jump(false);
+  ImGui::SameLine();
+  if (ImGui::ArrowButton("##log.next", ImGuiDir_Down)) jump(true);
+  if (index.hasQuery()) {
+    ImGui::SameLine();
+    auto matches = i18n_a("views.log_viewer.matches", index.matchCount());
+    ImGui::TextDisabled("%s%s", matches.c_str(), index.searching() ? "..." : "");
+  }
+  ImGui::SameLine();
+  ImGui::Checkbox("views.log_viewer.only_matches"_i18n, &onlyMatches);
+
+  if (ImGui::IsWindowFocused(ImGuiFocusedFlags_RootAndChildWindows) && ImGui::IsKeyPressed(ImGuiKey_F3))
+    jump(!ImGui::GetIO().KeyShift);
+}
+
+void LogViewer::drawLines() {
+  ImGui::BeginChild("##log.lines", ImVec2(0, 0), ImGuiChildFlags_None, ImGuiWindowFlags_HorizontalScrollbar);
+  ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(4, 1));
+
+  bool filter = onlyMatches && index.hasQuery();
+  size_t rows = filter ? index.matchCount() : index.lineCount();
+  float lineHeight = ImGui::GetTextLineHeightWithSpacing();
+  if (scrollToCursor && cursor >= 0) {
+    size_t row = filter ? index.matchIndex(cursor) : cursor;
+    ImGui::SetScrollY(row * lineHeight - ImGui::GetWindowHeight() * 0.5f);
+    scrollToCursor = false;
+  }
+
+  auto drawList = ImGui::GetWindowDrawList();
+  auto highlight = ImGui::GetColorU32(ImGuiCol_TextSelectedBg);
+  auto selected = ImGui::GetColorU32(ImGuiCol_Header);
+  ImGuiListClipper clipper;
+  clipper.Begin((int)std::min(rows, (size_t)INT_MAX), lineHeight);
+  while (clipper.Step()) {
+    for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+      size_t n = filter ? index.matchAt(row) : row;
+      auto line = index.line(n);
+      auto text = line.text.substr(0, LogIndex::MaxLineLength);
+      config->addGlyphs(text);
+
+      auto pos = ImGui::GetCursorScreenPos();
+      ImVec2 end(pos.x + ImGui::GetWindowWidth() + ImGui::GetScrollX(), pos.y + lineHeight);
+      if ((int64_t)n == cursor)
+        drawList->AddRectFilled(pos, end, selected);
+      else if (!filter && index.hasQuery() && index.isMatch(n))
+        drawList->AddRectFilled(pos, end, highlight);
+
+      ImGui::BeginGroup();
+      ImGui::TextDisabled("%9zu", n + 1);
+      ImGui::SameLine();
+      auto color = line.level >= 0 ? levelColors[line.level] : ImGui::GetStyleColorVec4(ImGuiCol_Text);
+      ImGui::PushStyleColor(ImGuiCol_Text, color);
+      ImGui::TextUnformatted(text.data(), text.data() + text.size());
+      ImGui::PopStyleColor();
+      ImGui::EndGroup();
+      if (ImGui::IsItemClicked()) cursor = n;
+    }
+  }
+
+  ImGui::PopStyleVar();
+  ImGui::EndChild();
+}
+
+void LogViewer::search() {
+  LogIndex::Query query;
+  query.pattern = pattern;
+  query.regex = regex;
+  query.matchCase = matchCase;
+  query.maxLevel = level;
+  query.prefix = prefix;
+  try {
+    index.search(query);
+    error.clear();
+  } catch (const std::regex_error &e) {
+    error = e.what();
+  }
+}
+
+void LogViewer::jump(bool forward) {
+  if (!index.hasQuery() || index.matchCount() == 0) return;
+  std::optional<size_t> next;
+  if (cursor < 0)
+    next = index.matchAt(forward ? 0 : index.matchCount() - 1);
+  else
+    next = index.nextMatch(cursor, forward);
+  if (!next) return;
+  cursor = *next;
+  scrollToCursor = true;
+}
+}  // namespace ImPlay::Views
@@ -14,10 +14,16 @@ Quickview::Quickview(Config *config, Mpv *mpv) : View(config, mpv) {
   addTab("subtitle", "views.quickview.subtitle", [this]() { drawSubtitleTabContent(); });
   // clang-format on
 
+  thumbnailer.updateCb = [this]() {
+    if (updateCb) updateCb();
+  };
+
   mpv->observeEvent(MPV_EVENT_FILE_LOADED, [this](void *data) {
     updateAudioEqChannels();
     applyAudioEq(false);
   });
+  // a file that couldn't be read may have been fixed, give it another try
+  mpv->observeProperty<mpv_node, MPV_FORMAT_NODE>("playlist", [this](mpv_node node) { thumbnailer.clearFailed(); });
 }
 
 void Quickview::show(const char *tab) {
@@ -29,10 +35,14 @@ void Quickview::show(const char *tab) {
 }
 
 void Quickview::draw() {
+  bool grid = gridDrawn;
+  gridDrawn = false;
   if (winMode)
     drawWindow();
   else
     drawPopup();
+  // the grid went out of view, nothing it asked for is needed anymore
+  if (grid && !gridDrawn) thumbnailer.request({});
 }
 
 void Quickview::drawWindow() {
@@ -198,27 +208,29 @@ void Quickview::drawPlaylistTabContent() {
     };
 
     if (items.empty()) emptyLabel();
-    for (auto &item : items) {
-      std::string title = item.title;
-      if (title.empty() && !item.filename().empty()) title = item.filename();
-      if (title.empty()) title = i18n_a("views.quickview.playlist.item", item.id + 1);
-      ImGui::PushID(item.id);
-      if (ImGui::Selectable("", selected == item.id)) selected = item.id;
-      if (ImGui::IsItemHovered() && ImGui::IsMouseDoubleClicked(0))
-        mpv->commandv("playlist-play-index", std::to_string(item.id).c_str(), nullptr);
-      if (ImGui::IsItemHovered(ImGuiHoveredFlags_DelayNormal)) ImGui::SetTooltip("%s", title.c_str());
-      if (ImGui::BeginPopupContextItem()) {
-        drawContextmenu(&item);
-        ImGui::EndPopup();
+    if (playlistGrid) drawPlaylistGrid(items, selected, drawContextmenu);
+    else
+      for (auto &item : items) {
+        std::string title = item.title;
+        if (title.empty() && !item.filename().empty()) title = item.filename();
+        if (title.empty()) title = i18n_a("views.quickview.playlist.item", item.id + 1);
+        ImGui::PushID(item.id);
+        if (ImGui::Selectable("", selected == item.id)) selected = item.id;
+        if (ImGui::IsItemHovered() && ImGui::IsMouseDoubleClicked(0))
+          mpv->commandv("playlist-play-index", std::to_string(item.id).c_str(), nullptr);
+        if (ImGui::IsItemHovered(ImGuiHoveredFlags_DelayNormal)) ImGui::SetTooltip("%s", title.c_str());
+        if (ImGui::BeginPopupContextItem()) {
+          drawContextmenu(&item);
+          ImGui::EndPopup();
+        }
+        ImGui::SameLine();
+        ImGui::PushStyleColor(ImGuiCol_Text,
+                              ImGui::GetStyleColorVec4(item.id == pos ? ImGuiCol_CheckMark : ImGuiCol_Text));
+        ImGui::TextEllipsis(title.c_str());
+        if (ImGui::IsWindowAppearing() && item.id == pos) ImGui::SetScrollHereY(0.25f);
+        ImGui::PopStyleColor();
+        ImGui::PopID();
       }
-      ImGui::SameLine();
-      ImGui::PushStyleColor(ImGuiCol_Text,
-                            ImGui::GetStyleColorVec4(item.id == pos ? ImGuiCol_CheckMark : ImGuiCol_Text));
-      ImGui::TextEllipsis(title.c_str());
-      if (ImGui::IsWindowAppearing() && item.id == pos) ImGui::SetScrollHereY(0.25f);
-      ImGui::PopStyleColor();
-      ImGui::PopID();
-    }
     ImGui::EndListBox();
   }
 
@@ -231,6 +243,9 @@ void Quickview::drawPlaylistTabContent() {
                  fmt::format("script-message-to implay playlist-sort {}", sort).c_str(),
                  "views.quickview.playlist.sort"_i18n))
     sort = !sort;
+  ImGui::SameLine();
+  if (toggleButton(ICON_FA_TH_LARGE, playlistGrid, "views.quickview.playlist.grid"_i18n, ImGuiCol_Text))
+    playlistGrid = !playlistGrid;
   ImGui::SameLine(ImGui::GetContentRegionAvail().x -
                   3 * (ImGui::CalcTextSize(ICON_FA_PLUS).x + style.FramePadding.x + style.ItemSpacing.x));
   iconButton(ICON_FA_PLUS, "script-message-to implay playlist-add-files", "views.quickview.playlist.add_files"_i18n,
@@ -240,6 +255,74 @@ void Quickview::drawPlaylistTabContent() {
   iconButton(ICON_FA_TRASH_ALT, "playlist-clear", "views.quickview.playlist.clear"_i18n);
 }
 
+// only the rows in view are submitted, and only their files are asked for thumbnails
+void Quickview::drawPlaylistGrid(std::vector<Mpv::PlayItem> &items, int &selected,
+                                 const std::function<void(Mpv::PlayItem *)> &contextMenu) {
+  auto &style = ImGui::GetStyle();
+  auto pos = mpv->playlistPos;
+  ImVec2 thumb(scaled(8), scaled(4.5f));
+  ImVec2 cell(thumb.x, thumb.y + ImGui::GetTextLineHeightWithSpacing());
+  float avail = ImGui::GetContentRegionAvail().x;
+  int cols = std::max(1, (int)((avail + style.ItemSpacing.x) / (cell.x + style.ItemSpacing.x)));
+  int rows = ((int)items.size() + cols - 1) / cols;
+  if (ImGui::IsWindowAppearing() && pos >= 0) ImGui::SetScrollY((float)(pos / cols) * (cell.y + style.ItemSpacing.y));
+
+  std::vector<std::string> wanted;
+  thumbnails.newFrame();
+  auto drawList = ImGui::GetWindowDrawList();
+  ImGuiListClipper clipper;
+  clipper.Begin(rows, cell.y + style.ItemSpacing.y);
+  while (clipper.Step()) {
+    for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+      for (int col = 0; col < cols && row * cols + col < (int)items.size(); col++) {
+        auto &item = items[row * cols + col];
+        std::string title = item.title;
+        if (title.empty() && !item.filename().empty()) title = item.filename();
+        if (title.empty()) title = i18n_a("views.quickview.playlist.item", item.id + 1);
+
+        if (col > 0) ImGui::SameLine();
+        ImGui::PushID(item.id);
+        ImVec2 min = ImGui::GetCursorScreenPos();
+        if (ImGui::Selectable("", selected == item.id, 0, cell)) selected = item.id;
+        if (ImGui::IsItemHovered() && ImGui::IsMouseDoubleClicked(0))
+          mpv->commandv("playlist-play-index", std::to_string(item.id).c_str(), nullptr);
+        if (ImGui::IsItemHovered(ImGuiHoveredFlags_DelayNormal)) ImGui::SetTooltip("%s", title.c_str());
+        if (ImGui::BeginPopupContextItem()) {
+          contextMenu(&item);
+          ImGui::EndPopup();
+        }
+
+        auto path = item.path.string();
+        ThumbnailAtlas::Cell tc;
+        if (thumbnails.lookup(path, tc)) {
+          float scale = std::min(thumb.x / tc.size.x, thumb.y / tc.size.y);
+          ImVec2 size = tc.size * scale, offset = (thumb - size) * 0.5f;
+          drawList->AddImage(thumbnails.texture(), min + offset, min + offset + size, tc.uv0, tc.uv1);
+        } else {
+          // streams would be fetched just for a thumbnail
+          bool remote = path.find("://") != std::string::npos;
+          if (!remote && !thumbnailer.failed(path)) wanted.push_back(path);
+          auto icon = remote || thumbnailer.failed(path) ? ICON_FA_FILE : ICON_FA_HOURGLASS;
+          drawList->AddText(min + (thumb - ImGui::CalcTextSize(icon)) * 0.5f, ImGui::GetColorU32(ImGuiCol_TextDisabled),
+                            icon);
+        }
+        auto color = ImGui::GetColorU32(item.id == pos ? ImGuiCol_CheckMark : ImGuiCol_Text);
+        ImVec2 textMin(min.x, min.y + thumb.y + style.ItemSpacing.y / 2), textMax(min.x + cell.x, min.y + cell.y);
+        ImGui::PushStyleColor(ImGuiCol_Text, color);
+        ImGui::RenderTextEllipsis(drawList, textMin, textMax, textMax.x, textMax.x, title.c_str(), nullptr, nullptr);
+        ImGui::PopStyleColor();
+        ImGui::PopID();
+      }
+    }
+  }
+  thumbnailer.request(wanted);
+  gridDrawn = true;
+}
+
+void Quickview::render() { thumbnails.upload(); }
+
+void Quickview::close() { thumbnails.destroy(); }
+
 void Quickview::drawChaptersTabContent() {
   auto items = mpv->chapters;
   auto pos = mpv->chapter;
@@ -0,0 +1,137 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <fmt/color.h>
+#include "helpers/utils.h"
+#include "views/seek_preview.h"
+
+namespace ImPlay::Views {
+SeekPreview::SeekPreview(Config *config, Mpv *mpv) : View(config, mpv) {}
+
+SeekPreview::~SeekPreview() {
+  {
+    std::lock_guard<std::mutex> l(lock);
+    quit = true;
+  }
+  cond.notify_one();
+  if (worker.joinable()) worker.join();
+}
+
+int SeekPreview::bucket(double time) const { return (int)std::lround(time / interval); }
+
+void SeekPreview::show(double time, float x, float top, float bottom) {
+  if (config->Data.Mpv.UseWid) return;
+  this->x = x;
+  this->top = top;
+  this->bottom = bottom;
+  visible = true;
+  {
+    std::lock_guard<std::mutex> l(lock);
+    path = mpv->property("path");
+    hovered = time;
+  }
+  // the decoder is only started once the seekbar is hovered
+  if (!worker.joinable()) worker = std::thread(&SeekPreview::run, this);
+  cond.notify_one();
+}
+
+void SeekPreview::hide() {
+  visible = false;
+  std::lock_guard<std::mutex> l(lock);
+  hovered = -1;
+}
+
+int SeekPreview::next() {
+  if (hovered < 0 || duration <= 0) return -1;
+  int count = (int)(duration / interval) + 1, center = bucket(hovered);
+  for (int d = 0; d <= Prefetch; d++) {
+    for (int b : {center - d, center + d}) {
+      if (b < 0 || b >= count || failed.count(b) || atlas.contains(std::to_string(b))) continue;
+      return b;
+    }
+  }
+  return -1;
+}
+
+void SeekPreview::run() {
+  std::unique_ptr<Thumbnailer> decoder;
+  std::unique_lock<std::mutex> l(lock);
+  while (true) {
+    cond.wait(l, [this]() { return quit || path != loaded || next() >= 0; });
+    if (quit) break;
+
+    if (path != loaded) {
+      auto file = loaded = path;
+      atlas.clear();
+      failed.clear();
+      duration = 0;
+      l.unlock();
+      if (!decoder) {
+        try {
+          decoder = std::make_unique<Thumbnailer>(ThumbnailAtlas::CellWidth, ThumbnailAtlas::CellHeight);
+        } catch (const std::exception &e) {
+          fmt::print(fg(fmt::color::red), "seek preview: {}\n", e.what());
+          return;
+        }
+      }
+      bool video = !file.empty() && decoder->load(file);
+      l.lock();
+      if (video) duration = decoder->duration();
+      // a few hundred buckets at most, and never finer than typical keyframe spacing
+      interval = std::max(2.0, duration / 500);
+      continue;
+    }
+
+    int b = next();
+    l.unlock();
+    Thumbnailer::Frame frame;
+    bool ok = decoder->grab(keyframes ? keyframes->before(b * interval) : b * interval, frame);
+    l.lock();
+    if (path != loaded) continue;
+    if (ok) {
+      atlas.put(std::to_string(b), std::move(frame));
+      if (updateCb) updateCb();
+    } else {
+      failed.insert(b);
+    }
+  }
+}
+
+void SeekPreview::draw() {
+  if (!visible) return;
+
+  ThumbnailAtlas::Cell cell;
+  bool found = false;
+  {
+    std::lock_guard<std::mutex> l(lock);
+    int center = bucket(hovered);
+    for (int d = 0; d <= Nearest && !found && hovered >= 0; d++)
+      found = atlas.lookup(std::to_string(center - d), cell) || atlas.lookup(std::to_string(center + d), cell);
+  }
+  if (!found) return;
+
+  auto vp = ImGui::GetMainViewport();
+  auto scale = ImGui::GetIO().DisplayFramebufferScale;
+  ImVec2 size(cell.size.x / scale.x, cell.size.y / scale.y);
+  float margin = scaled(0.3f);
+  float px = vp->WorkPos.x + x / scale.x - size.x / 2;
+  px = std::max(std::min(px, vp->WorkPos.x + vp->WorkSize.x - size.x), vp->WorkPos.x);
+  float py = vp->WorkPos.y + top / scale.y - size.y - margin;
+  if (py < vp->WorkPos.y) py = vp->WorkPos.y + bottom / scale.y + margin;
+
+  // over the video, under any window
+  auto drawList = ImGui::GetBackgroundDrawList(vp);
+  ImVec2 min(px, py), max = min + size;
+  drawList->AddImage(atlas.texture(), min, max, cell.uv0, cell.uv1);
+  drawList->AddRect(min, max, ImGui::GetColorU32(ImGuiCol_Border));
+}
+
+void SeekPreview::render() {
+  if (worker.joinable()) atlas.upload();
+}
+
+void SeekPreview::close() { atlas.destroy(); }
+}  // namespace ImPlay::Views
@@ -72,7 +72,8 @@ void Settings::drawButtons() {
         }
       }
     }
-    if (data.Font != config->Data.Font || data.Interface.Scale != config->Data.Interface.Scale ||
+    if (data.Font != config->Data.Font || data.Interface.Lang != config->Data.Interface.Lang ||
+        data.Interface.Scale != config->Data.Interface.Scale ||
         data.Interface.Rounding != config->Data.Interface.Rounding ||
         data.Interface.Shadow != config->Data.Interface.Shadow)
       config->FontReload = true;
@@ -101,7 +102,23 @@ void Settings::drawGeneralTab() {
     ImGui::Checkbox("views.settings.general.mpv.watch_later"_i18n, &data.Mpv.WatchLater);
     ImGui::SameLine();
     ImGui::HelpMarker("views.settings.general.mpv.watch_later.help"_i18n);
+    if (ImGui::Checkbox("views.settings.general.mpv.loudness"_i18n, &data.Mpv.Loudness))
+      appliers.push_back([&]() { mpv->commandv("script-message-to", "implay", "loudness-update", nullptr); });
+    ImGui::SameLine();
+    ImGui::HelpMarker("views.settings.general.mpv.loudness.help"_i18n);
     ImGui::Checkbox("views.settings.general.window.save"_i18n, &data.Window.Save);
+    ImGui::Checkbox("views.settings.general.control"_i18n, &data.Control.Enabled);
+    ImGui::SameLine();
+    ImGui::HelpMarker("views.settings.general.control.help"_i18n);
+    if (data.Control.Enabled) {
+      static char address[256] = {0};
+      strncpy(address, data.Control.Address.c_str(), IM_ARRAYSIZE(address) - 1);
+      ImGui::SameLine();
+      ImGui::SetNextItemWidth(scaled(12));
+      if (ImGui::InputTextWithHint("##control_address", config->controlAddress().c_str(), address,
+                                   IM_ARRAYSIZE(address)))
+        data.Control.Address = address;
+    }
     ImGui::Spacing();
     ImGui::TextUnformatted("views.settings.general.recent.limit"_i18n);
     ImGui::SameLine();
@@ -125,6 +142,13 @@ void Settings::drawGeneralTab() {
     if (ImGui::Combo("views.settings.general.debug.log_level"_i18n, &current, items, IM_ARRAYSIZE(items)))
       data.Debug.LogLevel = items[current];
     ImGui::InputInt("views.settings.general.debug.log_limit"_i18n, &data.Debug.LogLimit, 0);
+    ImGui::Checkbox("views.settings.general.debug.log_file"_i18n, &data.Debug.LogFile);
+    ImGui::SameLine();
+    ImGui::HelpMarker("views.settings.general.debug.log_file.help"_i18n);
+    if (data.Debug.LogFile) {
+      if (ImGui::InputInt("views.settings.general.debug.log_file_size"_i18n, &data.Debug.LogFileSize, 0))
+        data.Debug.LogFileSize = std::max(data.Debug.LogFileSize, 1);
+    }
     ImGui::Unindent();
     ImGui::EndTabItem();
   }
@@ -150,6 +174,12 @@ void Settings::drawInterfaceTab() {
     ImGui::SameLine(scaled(20));
     ImGui::Checkbox("views.settings.interface.shadow"_i18n, &data.Interface.Shadow);
 #endif
+    ImGui::Checkbox("views.settings.interface.waveform"_i18n, &data.Interface.Waveform);
+    ImGui::SameLine();
+    ImGui::HelpMarker("views.settings.interface.waveform.help"_i18n);
+    ImGui::Checkbox("views.settings.interface.scenes"_i18n, &data.Interface.Scenes);
+    ImGui::SameLine();
+    ImGui::HelpMarker("views.settings.interface.scenes.help"_i18n);
     ImGui::SliderInt("views.settings.interface.fps"_i18n, &data.Interface.Fps, 15, 200);
     ImGui::SameLine();
     ImGui::HelpMarker("views.settings.interface.fps.help"_i18n);
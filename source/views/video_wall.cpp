@@ -0,0 +1,180 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <thread>
+#include <fmt/color.h>
+#include <imgui.h>
+#include "helpers/utils.h"
+#include "views/video_wall.h"
+
+namespace ImPlay::Views {
+VideoWall::VideoWall(Config *config, Mpv *mpv) : View(config, mpv) {}
+
+void VideoWall::open(const std::vector<std::string> &paths) {
+  size_t count = std::min(paths.size(), MaxTiles);
+  if (count == 0) return;
+  // split the decoder threads between the tiles, so a full wall uses every core without oversubscribing
+  auto threads = std::to_string(std::max(1u, std::thread::hardware_concurrency() / (unsigned)count));
+  auto hwdec = mpv->property("hwdec");
+
+  std::vector<std::future<std::unique_ptr<Tile>>> jobs;
+  for (size_t i = 0; i < count; i++) {
+    jobs.push_back(std::async(std::launch::async, [=, path = paths[i]]() -> std::unique_ptr<Tile> {
+      auto tile = std::make_unique<Tile>();
+      tile->path = path;
+      try {
+        tile->mpv = std::make_unique<Mpv>();
+        tile->mpv->option("vo", "libmpv");
+        tile->mpv->option("hwdec", hwdec.c_str());
+        tile->mpv->option("vd-lavc-threads", threads.c_str());
+        tile->mpv->option("aid", i == 0 ? "auto" : "no");
+        tile->mpv->option("audio-display", "no");
+        tile->mpv->option("keep-open", "yes");
+        tile->mpv->option("demuxer-max-bytes", "32MiB");
+        tile->mpv->option("demuxer-max-back-bytes", "8MiB");
+        tile->mpv->init();
+      } catch (const std::exception &e) {
+        fmt::print(fg(fmt::color::red), "video wall: {}: {}\n", path, e.what());
+        return nullptr;
+      }
+      return tile;
+    }));
+  }
+  for (auto &job : jobs)
+    if (auto tile = job.get()) tiles.push_back(std::move(tile));
+  focused = 0;
+}
+
+void VideoWall::initRender(GLAddrLoadFunc load) {
+  for (auto &tile : tiles) {
+    tile->mpv->updateCb() = [this, t = tile.get()](Mpv *ctx) {
+      t->pending = true;
+      if (updateCb) updateCb();
+    };
+    tile->mpv->initRender(load);
+
+    glGenFramebuffers(1, &tile->fbo);
+    glGenTextures(1, &tile->tex);
+    glBindFramebuffer(GL_FRAMEBUFFER, tile->fbo);
+    glBindTexture(GL_TEXTURE_2D, tile->tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tile->tex, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // vo=libmpv needs the render context before the file is loaded
+    tile->mpv->commandv("loadfile", tile->path.c_str(), nullptr);
+  }
+  active_ = !tiles.empty();
+}
+
+void VideoWall::close() {
+  active_ = false;
+  for (auto &tile : tiles) {
+    glDeleteTextures(1, &tile->tex);
+    glDeleteFramebuffers(1, &tile->fbo);
+  }
+  tiles.clear();
+}
+
+bool VideoWall::render() {
+  if (!active_) return false;
+
+  bool rendered = false;
+  for (auto &tile : tiles) {
+    int w = tile->width, h = tile->height;
+    bool resized = w != tile->texWidth || h != tile->texHeight;
+    bool pending = tile->pending.exchange(false);
+    if (w <= 0 || h <= 0 || !(pending || resized)) continue;
+    // wantRender() must be asked after every update callback, even if the result is unused
+    if (!tile->mpv->wantRender() && !resized) continue;
+
+    if (resized) {
+      glBindTexture(GL_TEXTURE_2D, tile->tex);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+      glBindTexture(GL_TEXTURE_2D, 0);
+      tile->texWidth = w;
+      tile->texHeight = h;
+    }
+    tile->mpv->render(w, h, tile->fbo, false);
+    rendered = true;
+  }
+  return rendered;
+}
+
+void VideoWall::focus(size_t index) {
+  if (index >= tiles.size() || index == focused) return;
+  tiles[focused]->mpv->property("aid", "no");
+  tiles[index]->mpv->property("aid", "auto");
+  focused = index;
+}
+
+void VideoWall::draw() {
+  if (!active_) return;
+  for (auto &tile : tiles) tile->mpv->waitEvent();
+
+  auto vp = ImGui::GetMainViewport();
+  auto scale = ImGui::GetIO().DisplayFramebufferScale;
+  int cols = (int)std::ceil(std::sqrt((double)tiles.size()));
+  int rows = ((int)tiles.size() + cols - 1) / cols;
+  ImVec2 size(vp->WorkSize.x / cols, vp->WorkSize.y / rows);
+
+  ImGui::SetNextWindowPos(vp->WorkPos);
+  ImGui::SetNextWindowSize(vp->WorkSize);
+#ifdef IMGUI_HAS_VIEWPORT
+  ImGui::SetNextWindowViewport(vp->ID);
+#endif
+  ImGuiWindowFlags flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoBackground |
+                           ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoMove |
+                           ImGuiWindowFlags_NoBringToFrontOnFocus | ImGuiWindowFlags_NoNavInputs;
+#ifdef IMGUI_HAS_DOCK
+  flags |= ImGuiWindowFlags_NoDocking;
+#endif
+  ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0, 0));
+  ImGui::Begin("##video_wall", nullptr, flags);
+  ImGui::PopStyleVar();
+
+  auto drawList = ImGui::GetBackgroundDrawList(vp);
+  int exit = -1;
+  for (size_t i = 0; i < tiles.size(); i++) {
+    auto &tile = tiles[i];
+    ImVec2 min = vp->WorkPos + ImVec2(size.x * (i % cols), size.y * (i / cols));
+    ImVec2 max = min + size;
+
+    int w = (int)(size.x * scale.x), h = (int)(size.y * scale.y);
+    if (tile->width != w || tile->height != h) {
+      tile->width = w;
+      tile->height = h;
+      if (updateCb) updateCb();
+    }
+    drawList->AddImage(reinterpret_cast<ImTextureID>(static_cast<intptr_t>(tile->tex)), min, max);
+    if (i == focused) drawList->AddRect(min, max, ImGui::GetColorU32(ImGuiCol_CheckMark), 0, 0, scaled(0.15f));
+
+    ImGui::SetCursorScreenPos(min);
+    ImGui::InvisibleButton(fmt::format("##tile{}", i).c_str(), size);
+    if (ImGui::IsItemClicked(ImGuiMouseButton_Left)) focus(i);
+    if (ImGui::IsItemHovered() && ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) exit = (int)i;
+    if (ImGui::IsItemClicked(ImGuiMouseButton_Right)) mpv->command("script-message-to implay context-menu");
+  }
+
+  // keys go to the focused tile instead of the player while the wall has focus
+  if (ImGui::IsWindowFocused()) {
+    ImGui::SetNextFrameWantCaptureKeyboard(true);
+    auto &tile = tiles[focused];
+    if (ImGui::IsKeyPressed(ImGuiKey_Tab)) focus((focused + 1) % tiles.size());
+    if (ImGui::IsKeyPressed(ImGuiKey_Space)) tile->mpv->command("cycle pause");
+    if (ImGui::IsKeyPressed(ImGuiKey_LeftArrow)) tile->mpv->command("seek -5");
+    if (ImGui::IsKeyPressed(ImGuiKey_RightArrow)) tile->mpv->command("seek 5");
+    if (ImGui::IsKeyPressed(ImGuiKey_Enter)) exit = (int)focused;
+    if (ImGui::IsKeyPressed(ImGuiKey_Escape)) exit = (int)tiles.size();
+  }
+  ImGui::End();
+
+  // last, the callback destroys the tiles
+  if (exit >= 0 && exitCb) exitCb(exit < (int)tiles.size() ? tiles[exit]->path : "");
+}
+}  // namespace ImPlay::Views
@@ -0,0 +1,55 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <algorithm>
+#include <cmath>
+#include "helpers/utils.h"
+#include "views/waveform.h"
+
+namespace ImPlay::Views {
+Waveform::Waveform(Config *config, Mpv *mpv)
+    : View(config, mpv), peaks(std::filesystem::path(config->dir()) / "waveforms") {}
+
+void Waveform::show(float x1, float y1, float x2, float y2) {
+  if (config->Data.Mpv.UseWid) return;
+  min = ImVec2(x1, y1);
+  max = ImVec2(x2, y2);
+  visible = true;
+}
+
+void Waveform::draw() {
+  if (!visible) return;
+  double duration = mpv->property<double, MPV_FORMAT_DOUBLE>("duration");
+  if (duration <= 0) return;
+
+  auto vp = ImGui::GetMainViewport();
+  auto scale = ImGui::GetIO().DisplayFramebufferScale;
+  ImVec2 p1 = vp->WorkPos + ImVec2(min.x / scale.x, min.y / scale.y);
+  ImVec2 p2 = vp->WorkPos + ImVec2(max.x / scale.x, max.y / scale.y);
+  int count = (int)(p2.x - p1.x);
+  // over the video, under any window, faint enough to keep the osc slider readable
+  auto drawList = ImGui::GetBackgroundDrawList(vp);
+
+  if (config->Data.Interface.Waveform) {
+    auto columns = peaks.columns(count, duration);
+    auto color = ImGui::GetColorU32(ImGuiCol_PlotLines, 0.5f);
+    float mid = (p1.y + p2.y) / 2, half = (p2.y - p1.y) / 2;
+    for (int i = 0; i < (int)columns.size(); i++) {
+      float top = mid - columns[i].max * half / 32768.0f, bottom = mid - columns[i].min * half / 32768.0f;
+      drawList->AddRectFilled(ImVec2(p1.x + i, top), ImVec2(p1.x + i + 1, std::max(bottom, top + 1)), color);
+    }
+  }
+
+  // a tick along the bottom edge per scene cut, one per pixel at most
+  if (scenes != nullptr && config->Data.Interface.Scenes) {
+    auto color = ImGui::GetColorU32(ImGuiCol_PlotLinesHovered, 0.8f);
+    float height = std::max(2.0f, (p2.y - p1.y) / 4), last = -1;
+    for (double time : scenes->all()) {
+      float x = std::floor(p1.x + (float)(time / duration) * (p2.x - p1.x));
+      if (x == last) continue;
+      drawList->AddRectFilled(ImVec2(x, p2.y - height), ImVec2(x + 1, p2.y), color);
+      last = x;
+    }
+  }
+}
+}  // namespace ImPlay::Views
@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <stdexcept>
 #include <chrono>
+#include <future>
 #include <thread>
 #include <imgui.h>
 #include <imgui_internal.h>
@@ -13,36 +14,38 @@
 #ifdef _WIN32
 #include <windowsx.h>
 #endif
+#include "helpers/lang.h"
+#include "helpers/startup_trace.h"
 #include "theme.h"
 #include "window.h"
 
 namespace ImPlay {
-Window::Window(Config* config) : Player(config) {
-  initGLFW();
-  window = glfwCreateWindow(1280, 720, PLAYER_NAME, nullptr, nullptr);
-  if (window == nullptr) throw std::runtime_error("Failed to create window!");
-#ifdef _WIN32
-  hwnd = glfwGetWin32Window(window);
-  if (SUCCEEDED(OleInitialize(nullptr))) oleOk = true;
-#endif
-
-  initGui();
-  installCallbacks(window);
-  ImGui_ImplGlfw_InitForOpenGL(window, true);
-}
+Window::Window(Config* config) : Player(config) {}
 
 Window::~Window() {
-  ImGui_ImplGlfw_Shutdown();
-  exitGui();
+  if (ImGui::GetCurrentContext() != nullptr) {
+    ImGui_ImplGlfw_Shutdown();
+    exitGui();
+  }
 #ifdef _WIN32
   if (taskbarList != nullptr) taskbarList->Release();
   if (oleOk) OleUninitialize();
 #endif
 
-  glfwDestroyWindow(window);
+  if (window != nullptr) glfwDestroyWindow(window);
   glfwTerminate();
 }
 
+void Window::createWindow() {
+  window = glfwCreateWindow(1280, 720, PLAYER_NAME, nullptr, nullptr);
+  if (window == nullptr) throw std::runtime_error("Failed to create window!");
+#ifdef _WIN32
+  hwnd = glfwGetWin32Window(window);
+  if (SUCCEEDED(OleInitialize(nullptr))) oleOk = true;
+#endif
+  StartupTrace::get().mark("window");
+}
+
 void Window::initGLFW() {
   glfwSetErrorCallback(
       [](int error, const char* desc) { fmt::print(fg(fmt::color::red), "GLFW [{}]: {}\n", error, desc); });
@@ -70,15 +73,33 @@ void Window::initGLFW() {
   glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 }
 
+// Startup runs as a small dependency graph: mpv setup and the language data don't need
+// the window and are prepared while it's being created. The font atlas only needs the
+// window's scale, it's built while mpv's render context and the GL setup happen, and the
+// files are queued as soon as mpv can render, so demuxing overlaps with the rest.
 bool Window::init(OptionParser& parser) {
   mpv->wakeupCb() = [this](Mpv* ctx) { wakeup(); };
   mpv->updateCb() = [this](Mpv* ctx) { videoWaiter.notify(); };
-  if (!Player::init(parser.options)) return false;
+
+  auto langs = std::async(std::launch::async, []() { getLangGlyphRanges(); });
+  initGLFW();
+  bool useWid = config->Data.Mpv.UseWid;
+  if (!useWid) Player::start(parser.options);
+  createWindow();
+  langs.wait();
+  startFonts();
+  if (useWid) Player::start(parser.options);  // needs the native window
+  if (!Player::init()) return false;
 
   for (auto& path : parser.paths) {
     if (path == "-") mpv->property("input-terminal", "yes");
     mpv->commandv("loadfile", path.c_str(), "append-play", nullptr);
   }
+
+  initGui();
+  installCallbacks(window);
+  ImGui_ImplGlfw_InitForOpenGL(window, true);
+  StartupTrace::get().mark("gui");
 #if defined(__APPLE__) && defined(GLFW_PATCHED)
   const char** openedFileNames = glfwGetOpenedFilenames();
   if (openedFileNames != nullptr) {
@@ -113,15 +134,18 @@ void Window::run() {
       videoWaiter.wait();
       if (shutdown) break;
 
-      if (mpv->wantRender()) {
+      if (mpv->wantRender() || redrawVideo.exchange(false)) {
         renderVideo();
+        mirrorWaiter.notify();
         wakeup();
       }
+      if (renderCores()) wakeup();
     }
   });
 
   restoreState();
   glfwShowWindow(window);
+  StartupTrace::get().mark("shown");
 
   double lastTime = glfwGetTime();
   while (!glfwWindowShouldClose(window)) {
@@ -134,6 +158,7 @@ void Window::run() {
 
     render();
     updateCursor();
+    if (mirror != nullptr && glfwWindowShouldClose(mirror)) SetMirror(false);
 
     double targetDelta = 1.0f / config->Data.Interface.Fps;
     double delta = lastTime - glfwGetTime();
@@ -144,6 +169,7 @@ void Window::run() {
     lastTime += targetDelta;
   }
 
+  SetMirror(false);
   shutdown = true;
   videoWaiter.notify();
   videoRenderer.join();
@@ -153,6 +179,80 @@ void Window::run() {
 
 void Window::wakeup() { glfwPostEmptyEvent(); }
 
+// The mirror goes fullscreen on a monitor the player isn't on, e.g. a projector, or opens
+// as a small window if there's only one. It shares the player's GL context and copies the
+// rendered video texture, so nothing is decoded or rendered twice.
+void Window::SetMirror(bool on) {
+  if (on == (mirror != nullptr)) return;
+  if (!on) {
+    mirrorQuit = true;
+    mirrorWaiter.notify();
+    mirrorThread.join();
+    glfwDestroyWindow(mirror);
+    mirror = nullptr;
+    return;
+  }
+
+  GLFWmonitor *current = getMonitor(window), *target = nullptr;
+  int count;
+  auto monitors = glfwGetMonitors(&count);
+  for (int i = 0; i < count && target == nullptr; i++)
+    if (monitors[i] != current) target = monitors[i];
+
+  glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+  {
+    // the shared context must not be current on the render thread meanwhile
+    std::lock_guard<std::mutex> lock(contextLock);
+    if (target != nullptr) {
+      const GLFWvidmode *mode = glfwGetVideoMode(target);
+      glfwWindowHint(GLFW_REFRESH_RATE, mode->refreshRate);
+      mirror = glfwCreateWindow(mode->width, mode->height, PLAYER_NAME, target, window);
+      glfwWindowHint(GLFW_REFRESH_RATE, GLFW_DONT_CARE);
+    } else {
+      mirror = glfwCreateWindow(640, 360, PLAYER_NAME, nullptr, window);
+    }
+  }
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  if (mirror == nullptr) return;
+
+  int w, h;
+  glfwGetFramebufferSize(mirror, &w, &h);
+  mirrorWidth = w;
+  mirrorHeight = h;
+  glfwSetWindowUserPointer(mirror, this);
+  glfwSetFramebufferSizeCallback(mirror, [](GLFWwindow *target, int w, int h) {
+    auto win = static_cast<Window *>(glfwGetWindowUserPointer(target));
+    win->mirrorWidth = w;
+    win->mirrorHeight = h;
+    win->mirrorWaiter.notify();
+  });
+  glfwSetKeyCallback(mirror, [](GLFWwindow *target, int key, int scancode, int action, int mods) {
+    if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) glfwSetWindowShouldClose(target, GLFW_TRUE);
+  });
+
+  mirrorQuit = false;
+  mirrorThread = std::thread(&Window::mirrorLoop, this);
+}
+
+// paced by the mirror's own vsync, independent of the player window
+void Window::mirrorLoop() {
+  glfwMakeContextCurrent(mirror);
+  glfwSwapInterval(1);
+  GLuint readFbo;
+  glGenFramebuffers(1, &readFbo);
+
+  while (!mirrorQuit) {
+    // a new frame, or redraw now and then for resizes and the idle screen
+    mirrorWaiter.wait_until(std::chrono::steady_clock::now() + std::chrono::milliseconds(100));
+    if (mirrorQuit) break;
+    blitVideo(readFbo, mirrorWidth, mirrorHeight);
+    glfwSwapBuffers(mirror);
+  }
+
+  glDeleteFramebuffers(1, &readFbo);
+  glfwMakeContextCurrent(nullptr);
+}
+
 void Window::updateCursor() {
   if (!ownCursor || mpv->cursorAutohide == "" || ImGui::GetIO().WantCaptureMouse || ImGui::IsMouseDragging(0)) return;
 
@@ -284,13 +384,15 @@ std::string Window::GetClipboardString() {
 }
 
 void Window::GetMonitorSize(int* w, int* h) {
-  const GLFWvidmode* mode = glfwGetVideoMode(getMonitor(window));
+  // before the window is created, assume it opens on the primary monitor
+  const GLFWvidmode* mode = glfwGetVideoMode(window != nullptr ? getMonitor(window) : glfwGetPrimaryMonitor());
   *w = mode->width;
   *h = mode->height;
 }
 
 int Window::GetMonitorRefreshRate() {
-  const GLFWvidmode* mode = glfwGetVideoMode(getMonitor(window));
+  // before the window is created, assume it opens on the primary monitor
+  const GLFWvidmode* mode = glfwGetVideoMode(window != nullptr ? getMonitor(window) : glfwGetPrimaryMonitor());
   return mode->refreshRate;
 }
 
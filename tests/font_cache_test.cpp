@@ -0,0 +1,69 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <cstring>
+#include <filesystem>
+#include <imgui.h>
+#include <fonts/cascadia.h>
+#include "helpers/font_cache.h"
+#include "check.h"
+
+using namespace ImPlay;
+
+static void addFonts(ImFontAtlas *atlas) {
+  atlas->AddCustomRectRegular(20, 20);  // as the glyph loader reserves cells
+  atlas->AddFontFromMemoryCompressedTTF(cascadia_compressed_data, cascadia_compressed_size, 16);
+  atlas->AddFontFromMemoryCompressedTTF(cascadia_compressed_data, cascadia_compressed_size, 24);
+}
+
+// Usage: font_cache_test <dir>
+// A built atlas survives a trip through the cache file, and a different key misses it.
+int main(int argc, char *argv[]) {
+  CHECK(argc == 2);
+  std::filesystem::path dir = argv[1];
+  std::error_code ec;
+  std::filesystem::remove_all(dir, ec);
+
+  FontCache cache(dir);
+  cache.add(16);
+  cache.add(std::string("cascadia"));
+
+  ImFontAtlas built;
+  addFonts(&built);
+  CHECK(built.Build());
+  CHECK(cache.save(&built));
+
+  ImFontAtlas loaded;
+  CHECK(cache.load(&loaded));
+  CHECK(loaded.TexWidth == built.TexWidth && loaded.TexHeight == built.TexHeight);
+  CHECK(loaded.TexUvWhitePixel.x == built.TexUvWhitePixel.x && loaded.TexUvWhitePixel.y == built.TexUvWhitePixel.y);
+  CHECK(loaded.PackIdMouseCursors == built.PackIdMouseCursors && loaded.PackIdLines == built.PackIdLines);
+  CHECK(loaded.CustomRects.Size == built.CustomRects.Size);
+  for (int i = 0; i < built.CustomRects.Size; i++) {
+    auto &a = built.CustomRects[i], &b = loaded.CustomRects[i];
+    CHECK(a.X == b.X && a.Y == b.Y && a.Width == b.Width && a.Height == b.Height);
+  }
+
+  CHECK(loaded.Fonts.Size == built.Fonts.Size);
+  for (int i = 0; i < built.Fonts.Size; i++) {
+    ImFont *a = built.Fonts[i], *b = loaded.Fonts[i];
+    CHECK(a->FontSize == b->FontSize && a->Ascent == b->Ascent && a->Descent == b->Descent);
+    CHECK(a->Glyphs.Size == b->Glyphs.Size);
+    CHECK(memcmp(a->Glyphs.Data, b->Glyphs.Data, a->Glyphs.size_in_bytes()) == 0);
+    CHECK(b->FindGlyphNoFallback('A') != nullptr && b->FallbackGlyph != nullptr);
+  }
+
+  unsigned char *a, *b;
+  int w, h;
+  built.GetTexDataAsAlpha8(&a, &w, &h);
+  loaded.GetTexDataAsAlpha8(&b, &w, &h);
+  CHECK(memcmp(a, b, (size_t)w * h) == 0);
+
+  FontCache other(dir);
+  other.add(24);
+  other.add(std::string("cascadia"));
+  ImFontAtlas missed;
+  CHECK(!other.load(&missed));
+  CHECK(missed.Fonts.empty());
+  return 0;
+}
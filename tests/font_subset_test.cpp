@@ -0,0 +1,81 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <imgui.h>
+#include <fonts/cascadia.h>
+#include <fonts/fontawesome.h>
+#include "check.h"
+
+static std::string readFile(const char *path) {
+  std::ifstream f(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(f), {});
+}
+
+// the pixels a glyph covers in its atlas, row by row
+static std::string glyphPixels(ImFontAtlas *atlas, const ImFontGlyph *glyph) {
+  unsigned char *pixels;
+  int w, h;
+  atlas->GetTexDataAsAlpha8(&pixels, &w, &h);
+  int x0 = (int)(glyph->U0 * w + 0.5f), x1 = (int)(glyph->U1 * w + 0.5f);
+  int y0 = (int)(glyph->V0 * h + 0.5f), y1 = (int)(glyph->V1 * h + 0.5f);
+  std::string out;
+  for (int y = y0; y < y1; y++) out.append((const char *)pixels + (size_t)y * w + x0, x1 - x0);
+  return out;
+}
+
+// Usage: font_subset_test <cascadia|fontawesome> <subset.ttf>
+// The subset written by fontsubset loads in ImGui, and every codepoint of its .ranges file
+// renders as it does from the full font.
+int main(int argc, char *argv[]) {
+  CHECK(argc == 3);
+  std::string name = argv[1];
+  CHECK(name == "cascadia" || name == "fontawesome");
+
+  std::string rangesPath = argv[2];
+  rangesPath = rangesPath.substr(0, rangesPath.rfind('.')) + ".ranges";
+  auto rangesFile = readFile(rangesPath.c_str());
+  CHECK(!rangesFile.empty() && rangesFile.size() % 8 == 0);
+  ImVector<ImWchar> ranges;
+  for (size_t i = 0; i < rangesFile.size(); i += 4) {
+    uint32_t v = 0;
+    for (int k = 0; k < 4; k++) v |= (uint32_t)(uint8_t)rangesFile[i + k] << (k * 8);
+    if (v > IM_UNICODE_CODEPOINT_MAX) v = IM_UNICODE_CODEPOINT_MAX;
+    ranges.push_back((ImWchar)v);
+  }
+  ranges.push_back(0);
+
+  auto ttf = readFile(argv[2]);
+  CHECK(!ttf.empty());
+  ImFontConfig cfg;
+  cfg.FontDataOwnedByAtlas = false;
+  ImFontAtlas subset;
+  ImFont *sub = subset.AddFontFromMemoryTTF(ttf.data(), (int)ttf.size(), 16, &cfg, ranges.Data);
+  CHECK(subset.Build());
+
+  ImFontAtlas full;
+  ImFont *ref = name == "cascadia"
+                    ? full.AddFontFromMemoryCompressedTTF(cascadia_compressed_data, cascadia_compressed_size, 16,
+                                                          nullptr, ranges.Data)
+                    : full.AddFontFromMemoryCompressedTTF(fa_compressed_data, fa_compressed_size, 16, nullptr,
+                                                          ranges.Data);
+  CHECK(full.Build());
+
+  CHECK(sub->Ascent == ref->Ascent && sub->Descent == ref->Descent);
+  int glyphs = 0;
+  for (int i = 0; ranges[i] != 0; i += 2) {
+    for (unsigned int c = ranges[i]; c <= ranges[i + 1]; c++) {
+      auto a = ref->FindGlyphNoFallback((ImWchar)c), b = sub->FindGlyphNoFallback((ImWchar)c);
+      CHECK((a == nullptr) == (b == nullptr));
+      if (a == nullptr) continue;
+      CHECK(a->AdvanceX == b->AdvanceX && a->X0 == b->X0 && a->Y0 == b->Y0 && a->X1 == b->X1 && a->Y1 == b->Y1);
+      CHECK(glyphPixels(&full, a) == glyphPixels(&subset, b));
+      glyphs++;
+    }
+  }
+  CHECK(glyphs > 0);
+  return 0;
+}
@@ -0,0 +1,49 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include "helpers/lang_pack.h"
+#include "check.h"
+
+using namespace ImPlay;
+
+// Usage: lang_pack_test <lang.json>...
+// Each language file survives a trip through the binary pack.
+int main(int argc, char *argv[]) {
+  CHECK(argc > 1);
+  for (int i = 1; i < argc; i++) {
+    std::ifstream f(argv[i], std::ios::binary);
+    std::string json(std::istreambuf_iterator<char>(f), {});
+    LangData lang;
+    CHECK(LangPack::parseJson(json, lang));
+    CHECK(!lang.code.empty() && !lang.entries.empty());
+
+    auto pack = LangPack::write(lang);
+    LangData full;
+    CHECK(LangPack::read(pack, full, true));
+    CHECK(full.code == lang.code && full.title == lang.title && full.fallback == lang.fallback);
+    CHECK(full.entries == lang.entries);
+    CHECK(full.fonts.size() == lang.fonts.size());
+    for (size_t j = 0; j < lang.fonts.size(); j++) {
+      CHECK(full.fonts[j].path == lang.fonts[j].path && full.fonts[j].size == lang.fonts[j].size);
+      CHECK(full.fonts[j].glyph_range == lang.fonts[j].glyph_range);
+    }
+
+    // the language list reads the header only
+    LangData header;
+    CHECK(LangPack::read(pack, header, false));
+    CHECK(header.code == lang.code && header.title == lang.title && header.entries.empty());
+
+    // a truncated or foreign file is rejected, not half read
+    LangData bad;
+    CHECK(!LangPack::read(std::string_view(pack).substr(0, pack.size() - 1), bad, true));
+    auto foreign = pack;
+    foreign[0] = 'X';
+    CHECK(!LangPack::read(foreign, bad, false));
+  }
+  LangData lang;
+  CHECK(!LangPack::parseJson("{\"code\": 1}", lang));
+  return 0;
+}
@@ -0,0 +1,35 @@
+// Copyright (c) 2022-2023 tsl0922. All rights reserved.
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <string>
+#include <fmt/format.h>
+#include "helpers/thumbnailer.h"
+#include "check.h"
+
+using namespace ImPlay;
+
+static std::string testsrc(int width, int height) {
+  return fmt::format("av://lavfi:testsrc=duration=10:size={}x{}:rate=25", width, height);
+}
+
+// Usage: thumbnailer_test
+// One instance decodes several files in a row, as the seek preview and the thumbnail
+// workers reuse theirs. The files are generated by lavfi, no media is needed.
+int main() {
+  Thumbnailer thumbnailer(192, 108);
+  Thumbnailer::Frame frame;
+  for (auto [w, h] : {std::pair{320, 240}, std::pair{640, 360}, std::pair{320, 240}}) {
+    CHECK(thumbnailer.load(testsrc(w, h)));
+    CHECK(thumbnailer.grab(-1, frame));
+    CHECK(frame.width > 0 && frame.width <= 192 && frame.height > 0 && frame.height <= 108);
+    CHECK(frame.pixels.size() == (size_t)frame.width * frame.height * 4);
+  }
+
+  // a file without video, or one that fails, doesn't break the next load
+  CHECK(!thumbnailer.load("av://lavfi:sine=duration=10"));
+  CHECK(thumbnailer.load(testsrc(320, 240)));
+  CHECK(!thumbnailer.load("/nonexistent/implay-test.mkv"));
+  CHECK(thumbnailer.load(testsrc(640, 360)));
+  CHECK(thumbnailer.grab(-1, frame));
+  return 0;
+}